@@ -5,12 +5,87 @@
 // The rabbit cannot move to a cell that has snakes.
 // In this program the different paths will be counted by dynamic programming
 
-#include<cassert> // for assert function
+#include<cassert>            // for assert function
+#include<vector>             // for std::vector
+#include<algorithm>          // for std::min
+#include<array>              // for std::array
+#include<atomic>             // for std::atomic
+#include<chrono>             // for std::chrono::milliseconds
+#include<condition_variable> // for std::condition_variable
+#include<deque>              // for std::deque
+#include<map>                // for std::map
+#include<memory>             // for std::unique_ptr
+#include<mutex>              // for std::mutex
+#include<random>             // for std::mt19937_64, std::seed_seq
+#include<thread>             // for std::thread, std::this_thread::sleep_for
+#include<type_traits>        // for std::is_integral
 
-enum CELLFLAG {
-    SNAKE,
-    FLATLAND
-};
+#include "PathCounter.h" // for the counter policies
+#include "RowKernel.h"   // for scanRow
+#include "Grid.h"        // for CELLFLAG, PaddedGrid
+#include "PackedGrid.h"  // for PackedGrid, MappedGrid
+#include "GridStream.h"  // for GridStream
+#include "BatchKernel.h" // for GridBatch, scanBatchRow
+#include "Heatmap.h"     // for MappedHeatmap
+
+// Input
+//     Rows    : the number of matrix rows, known at compile time
+//     Columns : the number of matrix columns, known at compile time
+//     Counter : int by default, or any integral counter and uint128_t from PathCounter.h
+//     grid    : the pointer which points to the matrix by row major order
+// Output
+//     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+// Synopsis
+//     the dynamic programming of countAllPaths with the sizes as constants: the row is an array of Columns
+//     counters on the stack, the row kernel is unrolled over it, so a small row stays in registers and there is
+//     no allocation. It is constexpr, a grid known at compile time is counted in a static_assert or a constant table
+template<int Rows, int Columns, typename Counter = int>
+constexpr Counter countAllPaths(const CELLFLAG* grid) {
+    static_assert((Rows > 0) && (Columns > 0), "an empty grid has no source");
+    assert(grid[0] == FLATLAND);
+    assert(grid[Rows * Columns - 1] == FLATLAND);
+
+    Counter num_paths[Columns] = {};
+    num_paths[0] = Counter(1); // the source is reached from its virtual upper neighbour
+    for(int i = 0; i < Rows; i++) {
+        const CELLFLAG* flags = grid + i * Columns;
+        maskPaths(num_paths[0], flags[0]);
+#pragma GCC unroll 64
+        for(int j = 1; j < Columns; j++) {
+            num_paths[j] += num_paths[j - 1];
+            maskPaths(num_paths[j], flags[j]);
+        }
+    }
+
+    return num_paths[Columns - 1];
+}
+
+// Input
+//     grid    : the pointer which points to the matrix by row major order
+//     rows    : the number of matrix rows
+//     columns : the number of matrix columns
+//     paths   : the number of paths, written if the size has a specialization
+// Output
+//     true if rows * columns is one of the sizes counted by countAllPaths<Rows, Columns>, the square tiles
+//     of 4, 8 and 16 cells a side, and Counter is an integral counter
+template<typename Counter>
+bool countFixedSize(const CELLFLAG* grid, int rows, int columns, Counter& paths) {
+    if constexpr(std::is_integral<Counter>::value || std::is_same<Counter, uint128_t>::value) {
+        if(rows != columns) return false;
+        switch(rows) {
+        case 4:
+            paths = countAllPaths<4, 4, Counter>(grid);
+            return true;
+        case 8:
+            paths = countAllPaths<8, 8, Counter>(grid);
+            return true;
+        case 16:
+            paths = countAllPaths<16, 16, Counter>(grid);
+            return true;
+        }
+    }
+    return false;
+}
 
 // Input
 //     grid    : the pointer which points to the matrix by row major order
@@ -18,45 +93,591 @@ enum CELLFLAG {
 //     columns : the number of matrix columns
 // Output
 //     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+//     as Counter: int by default, or uint64_t, uint128_t, ModCounter and BigCounter from PathCounter.h
 // Synopsis
 //     The total number of different paths is counted by the dynamic programming:
 //     dp[i][j] = dp[i-1][j] + dp[i][j-1]
-int countAllPaths(CELLFLAG* grid, int rows, int columns) {
+//     only the row i is kept, dp[i-1][j] is the value left in the row by the previous iteration,
+//     and every row is a segmented prefix sum computed by scanRow from RowKernel.h.
+//     The sizes of countFixedSize go to their compile-time specializations
+template<typename Counter = int>
+Counter countAllPaths(CELLFLAG* grid, int rows, int columns) {
     assert(((grid != nullptr) && ((rows * columns) != 0)) || ((grid == nullptr) && ((rows * columns) == 0)));
     assert(grid[0] == FLATLAND);
     assert(grid[rows * columns - 1] == FLATLAND);
 
-    //grid to store the number of paths of every cell
-    int num_paths[rows * columns];
-    for(int i = 0; i < (rows * columns); i++) {
-        num_paths[i] = 0;
+    Counter fixed(0);
+    if(countFixedSize(grid, rows, columns, fixed)) {
+        return fixed;
+    }
+
+    // row to store the number of paths of every cell in the current row
+    std::vector<Counter> num_paths(columns, Counter(0));
+
+    // initialize the top-most row, the source is reached from its virtual left neighbour
+    scanRow(num_paths.data(), grid, columns, Counter(1));
+
+    // traverse the matrix until the destination
+    for(int i = 1; i < rows; i++) {
+        scanRow(num_paths.data(), grid + size_t(i) * columns, columns, Counter(0));
+    }
+
+    return num_paths[columns - 1];
+}
+
+// Input
+//     grid : the padded matrix, see Grid.h
+// Output
+//     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+// Synopsis
+//     the same dynamic programming as above, every row of flags starts on a cache line
+template<typename Counter = int>
+Counter countAllPaths(const PaddedGrid& grid) {
+    assert((grid.rows() > 0) && (grid.columns() > 0));
+    assert(grid[grid.source()] == FLATLAND);
+    assert(grid[grid.destination()] == FLATLAND);
+
+    std::vector<Counter> num_paths(grid.columns(), Counter(0));
+    scanRow(num_paths.data(), grid.row(0), grid.columns(), Counter(1));
+    for(int i = 1; i < grid.rows(); i++) {
+        scanRow(num_paths.data(), grid.row(i), grid.columns(), Counter(0));
+    }
+
+    return num_paths[grid.columns() - 1];
+}
+
+// Input
+//     grid : the bit-packed matrix, e.g. the view of a MappedGrid
+// Output
+//     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+// Synopsis
+//     the same dynamic programming as above, the row kernel reads the bits of every row in place
+template<typename Counter = int>
+Counter countAllPaths(const PackedGridView& grid) {
+    assert((grid.words != nullptr) && (grid.rows > 0) && (grid.columns > 0));
+    assert(grid.row(0)[0] == FLATLAND);
+    assert(grid.row(grid.rows - 1)[grid.columns - 1] == FLATLAND);
+
+    std::vector<Counter> num_paths(grid.columns, Counter(0));
+    scanRow(num_paths.data(), grid.row(0), grid.columns, Counter(1));
+    for(int i = 1; i < grid.rows; i++) {
+        scanRow(num_paths.data(), grid.row(i), grid.columns, Counter(0));
     }
-    
-    num_paths[0] = grid[0];
-    for(int i = 1; i < rows; i++) { // initialize the left-most column
-        if((num_paths[(i - 1) * columns] == 1) && (grid[i * columns] == FLATLAND)) {
-            num_paths[i * columns] = 1;
+
+    return num_paths[grid.columns - 1];
+}
+
+// Input
+//     stream : the bit-packed matrix read from a file or a pipe, see GridStream.h
+//     paths  : set to the number of different paths from top-left-most cell to the bottom-right-most cell
+// Output
+//     false if the stream ended before its last row
+// Synopsis
+//     the same dynamic programming as above over the chunks of rows as they are read, only the row of dp and
+//     the two chunks of the stream are in memory whatever the number of rows
+template<typename Counter = int>
+bool countAllPaths(GridStream& stream, Counter& paths) {
+    assert((stream.rows() > 0) && (stream.columns() > 0));
+    std::vector<Counter> num_paths(stream.columns(), Counter(0));
+    Counter entering(1); // the source is reached from its virtual left neighbour
+    int rowsCounted = 0;
+    for(PackedGridView chunk = stream.next(); chunk.rows > 0; chunk = stream.next()) {
+        for(int i = 0; i < chunk.rows; i++) {
+            scanRow(num_paths.data(), chunk.row(i), chunk.columns, entering);
+            entering = Counter(0);
         }
+        rowsCounted += chunk.rows;
+    }
+    paths = num_paths[stream.columns() - 1];
+    return (rowsCounted == stream.rows()) && !stream.truncated();
+}
+
+// Input
+//     batch : the grids of the same size counted together, see BatchKernel.h
+//     paths : paths[l] is set to the number of paths of the grid in lane l, for the batch.size() lanes
+// Synopsis
+//     the dynamic programming of countAllPaths run on every lane in lockstep, one vertical masked add per
+//     vector of lanes and cell, so BATCH_LANES grids cost about as much as one row kernel pass over one of them
+template<typename Counter = int>
+void countAllPaths(const GridBatch& batch, Counter* paths) {
+    const int columns = batch.columns();
+    std::vector<Counter, CacheLineAllocator<Counter>> num_paths(size_t(columns) * BATCH_LANES, Counter(0));
+    scanBatchRow(num_paths.data(), batch.row(0), columns, Counter(1));
+    for(int i = 1; i < batch.rows(); i++) {
+        scanBatchRow(num_paths.data(), batch.row(i), columns, Counter(0));
+    }
+    const Counter* destination = num_paths.data() + size_t(columns - 1) * BATCH_LANES;
+    for(int l = 0; l < batch.size(); l++) {
+        paths[l] = destination[l];
+    }
+}
+
+// A grid of countAllPathsBatched
+struct GridRef {
+    const CELLFLAG* grid; // the matrix by row major order
+    int rows;
+    int columns;
+};
+
+// Input
+//     grids : the grids to be counted, of any sizes and in any order
+// Output
+//     the number of paths of every grid, in the order of grids
+// Synopsis
+//     the grids are bucketed by size, and every bucket is counted BATCH_LANES grids at a time by the batch
+//     kernel, a GridBatch and its rows of dp being reused from one batch to the next
+template<typename Counter = int>
+std::vector<Counter> countAllPathsBatched(const std::vector<GridRef>& grids) {
+    std::map<std::pair<int, int>, std::vector<size_t>> buckets;
+    for(size_t g = 0; g < grids.size(); g++) {
+        assert((grids[g].rows > 0) && (grids[g].columns > 0));
+        buckets[std::make_pair(grids[g].rows, grids[g].columns)].push_back(g);
     }
-    
-    for(int i = 1; i < columns; i++) { // initialize the top-most column
-        if((num_paths[i - 1] == 1) && (grid[i] == FLATLAND)) {
-            num_paths[i] = 1;
+    std::vector<Counter> paths(grids.size(), Counter(0));
+    for(const auto& bucket : buckets) {
+        GridBatch batch(bucket.first.first, bucket.first.second);
+        const std::vector<size_t>& members = bucket.second;
+        Counter counted[BATCH_LANES];
+        for(size_t first = 0; first < members.size(); first += BATCH_LANES) {
+            batch.clear();
+            const size_t last = std::min(first + BATCH_LANES, members.size());
+            for(size_t k = first; k < last; k++) {
+                batch.add(grids[members[k]].grid);
+            }
+            countAllPaths(batch, counted);
+            for(size_t k = first; k < last; k++) {
+                paths[members[k]] = counted[k - first];
+            }
         }
     }
-    
-    // traverse the matrix until the destination
-    for(int i = 1; i < rows; i++) {
-        for(int j = 1; j < columns; j++) {
-            if(grid[i * columns + j] == FLATLAND) {
-                num_paths[i * columns + j] = num_paths[(i - 1) * columns + j] + num_paths[i * columns + j - 1];
+    return paths;
+}
+
+// Input
+//     numTileRows    : the number of tile rows
+//     numTileColumns : the number of tile columns
+//     numThreads     : the number of worker threads, the calling thread being one of them
+//     computeTile    : computeTile(tileRow, tileColumn), called once per tile and only once the tile above
+//                      and the tile on its left are done
+// Synopsis
+//     the wavefront scheduler: the tiles on the same tile anti-diagonal are computed in parallel.
+//     A tile becomes ready once both of its dependencies are done, there is no barrier between anti-diagonals.
+//     A pass going the other way, from the bottom-right tile, maps (tileRow, tileColumn) to
+//     (numTileRows - 1 - tileRow, numTileColumns - 1 - tileColumn) in computeTile
+template<typename ComputeTile>
+void runWavefront(int numTileRows, int numTileColumns, int numThreads, ComputeTile&& computeTile) {
+    assert((numTileRows > 0) && (numTileColumns > 0) && (numThreads > 0));
+    const int numTiles = numTileRows * numTileColumns;
+
+    // number of unfinished dependencies of every tile
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[numTiles]);
+    for(int t = 0; t < numTiles; t++) {
+        pending[t].store(int(t / numTileColumns > 0) + int(t % numTileColumns > 0), std::memory_order_relaxed);
+    }
+
+    std::mutex readyLock;
+    std::condition_variable readyCond;
+    std::deque<int> readyTiles(1, 0);
+    int doneTiles = 0;
+
+    auto worker = [&]() {
+        for(;;) {
+            int tile;
+            {
+                std::unique_lock<std::mutex> lock(readyLock);
+                readyCond.wait(lock, [&] { return !readyTiles.empty() || doneTiles == numTiles; });
+                if(readyTiles.empty()) return;
+                tile = readyTiles.front();
+                readyTiles.pop_front();
+            }
+
+            computeTile(tile / numTileColumns, tile % numTileColumns);
+
+            int newlyReady[2];
+            int numNewlyReady = 0;
+            bool finished;
+            if((tile % numTileColumns) + 1 < numTileColumns && pending[tile + 1].fetch_sub(1) == 1) {
+                newlyReady[numNewlyReady++] = tile + 1;
+            }
+            if(tile + numTileColumns < numTiles && pending[tile + numTileColumns].fetch_sub(1) == 1) {
+                newlyReady[numNewlyReady++] = tile + numTileColumns;
+            }
+            {
+                std::lock_guard<std::mutex> lock(readyLock);
+                for(int k = 0; k < numNewlyReady; k++) {
+                    readyTiles.push_back(newlyReady[k]);
+                }
+                finished = (++doneTiles == numTiles);
+            }
+            if(finished || numNewlyReady > 1) {
+                readyCond.notify_all();
+            }
+            else if(numNewlyReady == 1) {
+                readyCond.notify_one();
             }
         }
+    };
+
+    std::vector<std::thread> workers;
+    for(int t = 1; t < std::min(numThreads, numTiles); t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& t : workers) {
+        t.join();
     }
-    
-    return num_paths[rows * columns - 1];
 }
 
+// Input
+//     grid        : the pointer which points to the matrix by row major order
+//     rows        : the number of matrix rows
+//     columns     : the number of matrix columns
+//     numThreads  : the number of worker threads
+//     tileRows    : the number of rows of a tile
+//     tileColumns : the number of columns of a tile, tileColumns counters of the tile row should stay in L1
+// Output
+//     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid,
+//     exactly the same as countAllPaths
+// Synopsis
+//     The matrix is cut into tiles. A tile depends only on the tile above and the tile on its left,
+//     so the tiles are computed by the wavefront scheduler runWavefront.
+//     bottomEdge[j] carries dp of column j from one tile row to the next,
+//     rightEdge[i] carries dp of row i from one tile column to the next.
+template<typename Counter = int>
+Counter countAllPathsWavefront(CELLFLAG* grid, int rows, int columns, int numThreads,
+                               int tileRows = 256, int tileColumns = 2048) {
+    assert(((grid != nullptr) && ((rows * columns) != 0)) || ((grid == nullptr) && ((rows * columns) == 0)));
+    assert(grid[0] == FLATLAND);
+    assert(grid[rows * columns - 1] == FLATLAND);
+    assert((numThreads > 0) && (tileRows > 0) && (tileColumns > 0));
+
+    std::vector<Counter> bottomEdge(columns, Counter(0));
+    std::vector<Counter> rightEdge(rows, Counter(0));
+    rightEdge[0] = Counter(1); // the source is reached from its virtual left neighbour
+
+    auto computeTile = [&](int tileRow, int tileColumn) {
+        const int rowBegin = tileRow * tileRows;
+        const int rowEnd = std::min(rowBegin + tileRows, rows);
+        const int colBegin = tileColumn * tileColumns;
+        const int colEnd = std::min(colBegin + tileColumns, columns);
+        Counter* num_paths = bottomEdge.data() + colBegin;
+        const int width = colEnd - colBegin;
+        for(int i = rowBegin; i < rowEnd; i++) {
+            scanRow(num_paths, grid + size_t(i) * columns + colBegin, width, rightEdge[i]);
+            rightEdge[i] = num_paths[width - 1];
+        }
+    };
+    runWavefront((rows + tileRows - 1) / tileRows, (columns + tileColumns - 1) / tileColumns, numThreads, computeTile);
+
+    return bottomEdge[columns - 1];
+}
+
+// Input
+//     flagsOf     : flagsOf(i, column) is the flags of row i from column on, as scanRow reads them
+//     rows        : the number of matrix rows
+//     columns     : the number of matrix columns
+//     heatmap     : a heatmap of rows * columns, the paths through (i, j) are written to heatmap.row(i)[j]
+//     numThreads  : the number of worker threads
+//     tileRows    : the number of rows of a tile
+//     tileColumns : the number of columns of a tile
+// Output
+//     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+// Synopsis
+//     the paths through (i, j) are forward[i][j] * backward[i][j], the paths from the source to the cell times
+//     the paths from the cell to the destination. Two wavefronts over the same tiles:
+//     the backward pass from the bottom-right tile writes backward[i][j] to the heatmap,
+//         backward[i][j] = flag ? backward[i+1][j] + backward[i][j+1] : 0
+//     belowEdge[j] carrying backward of column j up from one tile row to the next, leftEdge[i] carrying
+//     backward of row i from one tile column to the one on its left;
+//     the forward pass is the dynamic programming of countAllPathsWavefront, every tile multiplying its forward
+//     values into the backward values of the heatmap.
+//     So the two row buffers, edges of the passes, and the tile being written are all the memory of a worker,
+//     the pages of a tile are released to the page cache once it is done, and a heatmap larger than RAM is
+//     written back by the kernel as the passes go
+template<typename Counter, typename FlagsOf>
+Counter countPathsThroughTiles(FlagsOf&& flagsOf, int rows, int columns, MappedHeatmap<Counter>& heatmap,
+                               int numThreads, int tileRows, int tileColumns) {
+    assert((rows > 0) && (columns > 0) && (heatmap.rows() == rows) && (heatmap.columns() == columns));
+    assert((numThreads > 0) && (tileRows > 0) && (tileColumns > 0));
+    const int numTileRows = (rows + tileRows - 1) / tileRows;
+    const int numTileColumns = (columns + tileColumns - 1) / tileColumns;
+
+    std::vector<Counter> belowEdge(columns, Counter(0));
+    std::vector<Counter> leftEdge(rows, Counter(0));
+    leftEdge[rows - 1] = Counter(1); // the destination reaches its virtual right neighbour
+    runWavefront(numTileRows, numTileColumns, numThreads, [&](int tileRow, int tileColumn) {
+        const int rowBegin = (numTileRows - 1 - tileRow) * tileRows;
+        const int rowEnd = std::min(rowBegin + tileRows, rows);
+        const int colBegin = (numTileColumns - 1 - tileColumn) * tileColumns;
+        const int colEnd = std::min(colBegin + tileColumns, columns);
+        for(int i = rowEnd - 1; i >= rowBegin; i--) {
+            const auto flags = flagsOf(i, colBegin);
+            Counter* backward = heatmap.row(i);
+            Counter right = leftEdge[i];
+            for(int j = colEnd - 1; j >= colBegin; j--) {
+                right += belowEdge[j];
+                maskPaths(right, flags[j - colBegin]);
+                belowEdge[j] = right;
+                backward[j] = right;
+            }
+            leftEdge[i] = right;
+        }
+        heatmap.release(rowBegin, rowEnd, colBegin, colEnd);
+    });
+
+    std::vector<Counter> bottomEdge(columns, Counter(0));
+    std::vector<Counter> rightEdge(rows, Counter(0));
+    rightEdge[0] = Counter(1); // the source is reached from its virtual left neighbour
+    runWavefront(numTileRows, numTileColumns, numThreads, [&](int tileRow, int tileColumn) {
+        const int rowBegin = tileRow * tileRows;
+        const int rowEnd = std::min(rowBegin + tileRows, rows);
+        const int colBegin = tileColumn * tileColumns;
+        const int colEnd = std::min(colBegin + tileColumns, columns);
+        Counter* forward = bottomEdge.data() + colBegin;
+        const int width = colEnd - colBegin;
+        for(int i = rowBegin; i < rowEnd; i++) {
+            scanRow(forward, flagsOf(i, colBegin), width, rightEdge[i]);
+            rightEdge[i] = forward[width - 1];
+            Counter* through = heatmap.row(i) + colBegin;
+            for(int j = 0; j < width; j++) {
+                through[j] = forward[j] * through[j];
+            }
+        }
+        heatmap.release(rowBegin, rowEnd, colBegin, colEnd);
+    });
+
+    return bottomEdge[columns - 1];
+}
+
+// Input
+//     grid        : the pointer which points to the matrix by row major order
+//     rows        : the number of matrix rows
+//     columns     : the number of matrix columns
+//     heatmap     : a heatmap created with rows and columns, see Heatmap.h
+//     numThreads  : the number of worker threads
+//     tileRows    : the number of rows of a tile
+//     tileColumns : the number of columns of a tile
+// Output
+//     the number of different paths, heatmap.row(i)[j] being the number of them through (i, j)
+// Synopsis
+//     see countPathsThroughTiles; the counts of the cells near the middle of a large grid overflow any fixed
+//     width, hence ModCounter by default
+template<typename Counter = ModCounter>
+Counter countPathsThrough(const CELLFLAG* grid, int rows, int columns, MappedHeatmap<Counter>& heatmap,
+                          int numThreads = 1, int tileRows = 256, int tileColumns = 2048) {
+    assert(grid != nullptr);
+    assert(grid[0] == FLATLAND);
+    assert(grid[size_t(rows) * columns - 1] == FLATLAND);
+    auto flagsOf = [&](int i, int column) { return grid + size_t(i) * columns + column; };
+    return countPathsThroughTiles(flagsOf, rows, columns, heatmap, numThreads, tileRows, tileColumns);
+}
+
+// Input
+//     grid        : the bit-packed matrix, e.g. the view of a MappedGrid, so the grid streams from its file too
+//     tileColumns : a multiple of 64, so a tile starts on a word of every row
+//     the others as above
+template<typename Counter = ModCounter>
+Counter countPathsThrough(const PackedGridView& grid, MappedHeatmap<Counter>& heatmap,
+                          int numThreads = 1, int tileRows = 256, int tileColumns = 2048) {
+    assert((grid.words != nullptr) && (tileColumns % 64 == 0));
+    assert(grid.row(0)[0] == FLATLAND);
+    assert(grid.row(grid.rows - 1)[grid.columns - 1] == FLATLAND);
+    auto flagsOf = [&](int i, int column) { return PackedBits{ grid.row(i).words + column / 64 }; };
+    return countPathsThroughTiles(flagsOf, grid.rows, grid.columns, heatmap, numThreads, tileRows, tileColumns);
+}
+
+// Path counter which keeps the whole dp table, so that a grid changing one cell at a time is recounted
+// without redoing the whole dynamic programming.
+// A cell only influences the cells below and on its right, so after a change at (row, column)
+// row is recomputed from column onwards, every following row from the first column which changed
+// in the row above, and the update stops at the first row which comes out unchanged.
+// The flags and the dp table are laid out as a PaddedGrid, the dp of the border is zero but on the left of the
+// source where it is the 1 path entering the grid, so every cell adds the one above and the one on its left.
+template<typename Counter = int>
+class IncrementalCounter {
+public:
+    // Input
+    //     grid    : the pointer which points to the matrix by row major order, it is copied
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    IncrementalCounter(const CELLFLAG* grid, int rows, int columns)
+        : rows(rows), columns(columns), grid(grid, rows, columns), num_paths(this->grid.size(), Counter(0)) {
+        assert((rows > 0) && (columns > 0));
+        num_paths[this->grid.source() - 1] = Counter(1);
+        for(int i = 0; i < rows; i++) {
+            recomputeRow(i, 0);
+        }
+    }
+
+    // Output
+    //     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+    Counter count() const {
+        return num_paths[grid.destination()];
+    }
+
+    CELLFLAG cell(int row, int column) const {
+        return grid[grid.cell(row, column)];
+    }
+
+    // Input
+    //     row, column : the cell to be changed
+    //     flag        : the new flag of the cell
+    // Output
+    //     the number of cells recomputed
+    long long setCell(int row, int column, CELLFLAG flag) {
+        assert((row >= 0) && (row < rows) && (column >= 0) && (column < columns));
+        if(cell(row, column) == flag) return 0;
+        grid[grid.cell(row, column)] = flag;
+
+        long long recomputed = 0;
+        int begin = column;
+        for(int i = row; i < rows; i++) {
+            recomputed += columns - begin;
+            begin = recomputeRow(i, begin);
+            if(begin == columns) break; // the row is unchanged, so are the rows below
+        }
+        return recomputed;
+    }
+
+    long long toggleCell(int row, int column) {
+        return setCell(row, column, (cell(row, column) == SNAKE) ? FLATLAND : SNAKE);
+    }
+
+private:
+    // Input
+    //     i     : the row to be recomputed
+    //     begin : the first column to be recomputed, the columns before it are up to date
+    // Output
+    //     the first column whose value changed, columns if none
+    int recomputeRow(int i, int begin) {
+        Counter* row = num_paths.data() + grid.cell(i, 0);
+        const Counter* up = row - grid.stride();
+        const CELLFLAG* flags = grid.row(i);
+        int firstChanged = columns;
+        for(int j = begin; j < columns; j++) {
+            Counter value = up[j];
+            value += row[j - 1];
+            maskPaths(value, flags[j]);
+            if((firstChanged == columns) && (value != row[j])) {
+                firstChanged = j;
+            }
+            row[j] = value;
+        }
+        return firstChanged;
+    }
+
+    const int rows;
+    const int columns;
+    PaddedGrid grid;
+    std::vector<Counter> num_paths; // the whole dp table, by the cells of grid
+};
+
+// Uniform sampler of the paths.
+// num_paths[i][j] is the number of paths from the source to (i, j), the dp table of countAllPaths kept whole;
+// a path is drawn backwards from the destination, every cell coming from the left with probability
+// num_paths[i][j-1] / num_paths[i][j] and from above otherwise, so every path has probability 1 / count().
+// Counter must be exact: uint64_t, uint128_t or BigCounter for the grids whose count overflows 128 bits.
+template<typename Counter = uint64_t>
+class PathSampler {
+public:
+    // Input
+    //     grid    : the pointer which points to the matrix by row major order
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    PathSampler(const CELLFLAG* grid, int rows, int columns)
+        : rows(rows), columns(columns), num_paths(size_t(rows) * columns) {
+        assert((rows > 0) && (columns > 0));
+        for(int i = 0; i < rows; i++) {
+            Counter* row = num_paths.data() + size_t(i) * columns;
+            for(int j = 0; j < columns; j++) {
+                Counter value = (i > 0) ? row[j - columns] : Counter(0);
+                value += (j > 0) ? row[j - 1] : Counter(i == 0 ? 1 : 0);
+                maskPaths(value, grid[size_t(i) * columns + j]);
+                if constexpr(std::is_same<Counter, BigCounter>::value) value.normalize();
+                row[j] = value;
+            }
+        }
+    }
+
+    // Output
+    //     the number of different paths, zero if there is nothing to sample
+    const Counter& count() const {
+        return num_paths.back();
+    }
+
+    // every path has the same number of cells
+    int length() const { return rows + columns - 1; }
+
+    // Input
+    //     rng  : the generator of uniform 64-bit words
+    //     path : the array of length() cells to be written, the cell indices by row major order from the source
+    // Output
+    //     false if there is no path
+    // Synopsis
+    //     O(rows + columns) choices, each one O(1) expected words of rng for every counter
+    template<typename Rng>
+    bool sample(Rng& rng, int* path) const {
+        if(count() == Counter(0)) return false;
+        int i = rows - 1;
+        int j = columns - 1;
+        for(int k = length() - 1; k > 0; k--) {
+            const size_t pos = size_t(i) * columns + j;
+            path[k] = int(pos);
+            if((i == 0) || ((j > 0) && chooseFirst(rng, num_paths[pos - 1], num_paths[pos]))) {
+                j--;
+            }
+            else {
+                i--;
+            }
+        }
+        path[0] = 0;
+        return true;
+    }
+
+    // Input
+    //     seed       : the seed of the batch, the same seed always gives the same paths whatever numThreads is
+    //     numSamples : the number of paths to be drawn
+    //     paths      : the array of numSamples * length() cells to be written, path after path
+    //     numThreads : the number of worker threads
+    // Output
+    //     false if there is no path
+    // Synopsis
+    //     the samples are cut into blocks of SAMPLE_BLOCK, the block b is drawn with its own std::mt19937_64 stream
+    //     seeded by (seed, b), and the worker t draws the blocks t, t + numThreads, ...
+    bool sampleBatch(uint64_t seed, long long numSamples, int* paths, int numThreads) const {
+        assert(numThreads > 0);
+        if(count() == Counter(0)) return false;
+        const long long numBlocks = (numSamples + SAMPLE_BLOCK - 1) / SAMPLE_BLOCK;
+        auto worker = [&](int t) {
+            std::mt19937_64 rng;
+            for(long long b = t; b < numBlocks; b += numThreads) {
+                std::seed_seq stream{ uint32_t(seed), uint32_t(seed >> 32), uint32_t(b), uint32_t(b >> 32) };
+                rng.seed(stream);
+                const long long end = std::min(numSamples, (b + 1) * SAMPLE_BLOCK);
+                for(long long n = b * SAMPLE_BLOCK; n < end; n++) {
+                    sample(rng, paths + n * length());
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for(int t = 1; t < numThreads; t++) {
+            workers.emplace_back(worker, t);
+        }
+        worker(0);
+        for(std::thread& t : workers) {
+            t.join();
+        }
+        return true;
+    }
+
+    static constexpr long long SAMPLE_BLOCK = 1024;
+
+private:
+    const int rows;
+    const int columns;
+    std::vector<Counter> num_paths; // the whole dp table by row major order
+};
+
 // This case will cover the 3*3 matrix with 3 snakes
 void testZeroPath1() {
     constexpr int rows = 3;
@@ -127,7 +748,922 @@ void testNumPathOfRectMatrix2() {
     assert(countAllPaths(*grid, rows, cols) == result);
 }
 
+// This case will cover the 18*18 matrix without snakes, whose number of paths is beyond int
+void testCounterPolicies() {
+    constexpr int rows = 18;
+    constexpr int cols = 18;
+    const char* result = "2333606220"; // C(34, 17)
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    assert(toString(countAllPaths<uint64_t>(grid.data(), rows, cols)) == result);
+    assert(toString(countAllPaths<uint128_t>(grid.data(), rows, cols)) == result);
+    assert(countAllPaths<ModCounter>(grid.data(), rows, cols).value() == 2333606220ull % 998244353);
+    assert(toString(countAllPaths<BigCounter>(grid.data(), rows, cols)) == result);
+}
+
+// This case will cover the 60*60 matrix with snakes, compare BigCounter with uint128_t and ModCounter
+void testBigCounter() {
+    constexpr int rows = 60;
+    constexpr int cols = 60;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i += 7) {
+        grid[i] = SNAKE;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+
+    BigCounter big = countAllPaths<BigCounter>(grid.data(), rows, cols);
+    assert(toString(big) == toString(countAllPaths<uint128_t>(grid.data(), rows, cols)));
+    assert(big.modulo(998244353) == countAllPaths<ModCounter>(grid.data(), rows, cols).value());
+
+    std::vector<CELLFLAG> open(200 * 200, FLATLAND);
+    assert(countAllPaths<BigCounter>(open.data(), 200, 200).modulo(998244353) == countAllPaths<ModCounter>(open.data(), 200, 200).value());
+}
+
+// This case will cover random matrices, the wavefront must agree with the serial dynamic programming
+void testWavefront() {
+    constexpr int rows = 97;
+    constexpr int cols = 131;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 28) < 2 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+
+    const ModCounter serial = countAllPaths<ModCounter>(grid.data(), rows, cols);
+    assert(serial != ModCounter(0));
+    assert(countAllPathsWavefront<ModCounter>(grid.data(), rows, cols, 1) == serial);
+    assert(countAllPathsWavefront<ModCounter>(grid.data(), rows, cols, 4, 7, 16) == serial);
+    assert(countAllPathsWavefront<ModCounter>(grid.data(), rows, cols, 3, 1, 1) == serial);
+    assert(countAllPathsWavefront<ModCounter>(grid.data(), rows, cols, 8, 200, 13) == serial);
+
+    std::vector<CELLFLAG> open(40 * 30, FLATLAND);
+    assert(toString(countAllPathsWavefront<BigCounter>(open.data(), 40, 30, 4, 8, 8)) == toString(countAllPaths<uint64_t>(open.data(), 40, 30)));
+}
+
+// This case will cover every row kernel the cpu supports, they must agree with the scalar kernel
+void testRowKernels() {
+    constexpr int rows = 41;
+    constexpr int cols = 53; // not a multiple of any vector width
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 29) == 0 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+    std::vector<CELLFLAG> open(30 * 31, FLATLAND);
+
+    const rowkernel::Isa detected = rowkernel::detectedIsa();
+    rowkernel::selectedIsa() = rowkernel::SCALAR;
+    const int expected32 = countAllPaths<int>(grid.data(), rows, cols);
+    const uint64_t expected64 = countAllPaths<uint64_t>(grid.data(), rows, cols);
+    const uint64_t expectedOpen = countAllPaths<uint64_t>(open.data(), 30, 31);
+    for(int isa = rowkernel::AVX2; isa <= detected; isa++) {
+        rowkernel::selectedIsa() = rowkernel::Isa(isa);
+        assert(countAllPaths<int>(grid.data(), rows, cols) == expected32);
+        assert(countAllPaths<uint64_t>(grid.data(), rows, cols) == expected64);
+        assert(countAllPaths<uint64_t>(open.data(), 30, 31) == expectedOpen);
+        assert(countAllPathsWavefront<uint64_t>(grid.data(), rows, cols, 2, 5, 19) == expected64);
+    }
+    rowkernel::selectedIsa() = detected;
+    assert(expectedOpen == 59132290782430712ull); // C(59, 29)
+}
+
+// This case will cover the bit-packed matrices, in memory and mapped from a file
+void testPackedGrid() {
+    constexpr int rows = 37;
+    constexpr int cols = 150; // rows are padded to 192 bits
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 29) == 0 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+    PackedGrid packed(grid.data(), rows, cols);
+
+    const rowkernel::Isa detected = rowkernel::detectedIsa();
+    for(int isa = rowkernel::SCALAR; isa <= detected; isa++) {
+        rowkernel::selectedIsa() = rowkernel::Isa(isa);
+        assert(countAllPaths<int>(packed.view()) == countAllPaths<int>(grid.data(), rows, cols));
+        assert(countAllPaths<uint64_t>(packed.view()) == countAllPaths<uint64_t>(grid.data(), rows, cols));
+    }
+    rowkernel::selectedIsa() = detected;
+
+    char path[] = "/tmp/packed_grid_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    assert(packed.write(path));
+    MappedGrid mapped;
+    assert(mapped.open(path));
+    assert((mapped.view().rows == rows) && (mapped.view().columns == cols));
+    assert(countAllPaths<ModCounter>(mapped.view()) == countAllPaths<ModCounter>(grid.data(), rows, cols));
+    mapped.close();
+    unlink(path);
+
+    CELLFLAG small[2][3] = { {FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, SNAKE, FLATLAND} };
+    assert(countAllPaths(PackedGrid(*small, 2, 3).view()) == 1);
+}
+
+// This case will cover a 37*150 matrix laid out with its SNAKE border, the cells and rows of the padded grid
+// must map back to the matrix and count the same number of paths
+void testPaddedGrid() {
+    constexpr int rows = 37;
+    constexpr int cols = 150;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 29) == 0 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+    const PaddedGrid padded(grid.data(), rows, cols);
+    PackedGrid packed(grid.data(), rows, cols);
+    assert(PaddedGrid(packed.view(), rows, cols).size() == padded.size());
+
+    assert((padded.stride() > cols) && (padded.stride() % PADDED_ROW_CELLS == 0));
+    for(int pos = 0; pos < rows * cols; pos++) {
+        const int cell = padded.cellOf(pos);
+        assert((padded.posOf(cell) == pos) && (padded[cell] == grid[pos]));
+    }
+    assert((padded.cell(-1, -1) >= 0) && (size_t(padded.cell(rows, cols)) < padded.size()));
+    for(int i = -1; i <= rows; i++) { // the border, its corners included
+        assert((padded[padded.cell(i, -1)] == SNAKE) && (padded[padded.cell(i, cols)] == SNAKE));
+    }
+    for(int j = 0; j < cols; j++) {
+        assert((padded[padded.cell(-1, j)] == SNAKE) && (padded[padded.cell(rows, j)] == SNAKE));
+    }
+    for(int i = 0; i < rows; i++) {
+        assert(reinterpret_cast<uintptr_t>(padded.row(i)) % CACHE_LINE_BYTES == 0);
+    }
+    assert(countAllPaths<uint64_t>(padded) == countAllPaths<uint64_t>(grid.data(), rows, cols));
+}
+
+// This case will cover random single cell changes, the incremental counter must agree with a full recount
+void testIncrementalCounter() {
+    constexpr int rows = 33;
+    constexpr int cols = 29;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 29) == 0 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+
+    IncrementalCounter<uint64_t> counter(grid.data(), rows, cols);
+    assert(counter.count() == countAllPaths<uint64_t>(grid.data(), rows, cols));
+    for(int edit = 0; edit < 500; edit++) {
+        unsigned h = unsigned((edit + 1) * 2246822519u);
+        const int i = int(h % rows);
+        const int j = int((h >> 10) % cols);
+        if(((i == 0) && (j == 0)) || ((i == rows - 1) && (j == cols - 1))) continue;
+        grid[i * cols + j] = (grid[i * cols + j] == SNAKE) ? FLATLAND : SNAKE;
+        counter.toggleCell(i, j);
+        assert(counter.count() == countAllPaths<uint64_t>(grid.data(), rows, cols));
+    }
+    assert(counter.setCell(1, 1, counter.cell(1, 1)) == 0);
+}
+
+// Input
+//     path : the cells of a sampled path
+// Output
+//     true if the path moves rightwards or downwards from the source to the destination on FLATLAND only
+bool isPath(const int* path, const CELLFLAG* grid, int rows, int columns) {
+    if((path[0] != 0) || (path[rows + columns - 2] != rows * columns - 1)) return false;
+    for(int k = 1; k < rows + columns - 1; k++) {
+        const int step = path[k] - path[k - 1];
+        if(((step != 1) || (path[k] % columns == 0)) && (step != columns)) return false;
+        if(grid[path[k]] == SNAKE) return false;
+    }
+    return true;
+}
+
+// This case will cover a 4*5 matrix with 2 snakes whose 19 paths must be drawn uniformly,
+// the batches of any number of threads and a 40*40 matrix counted by BigCounter
+void testPathSampler() {
+    constexpr int rows = 4;
+    constexpr int cols = 5;
+    constexpr int numSamples = 19 * 2000;
+
+    CELLFLAG grid[rows][cols] = { {FLATLAND, FLATLAND, FLATLAND, SNAKE, FLATLAND}, {FLATLAND, FLATLAND, FLATLAND, FLATLAND, FLATLAND},
+                                  {FLATLAND, SNAKE, FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, FLATLAND, FLATLAND, FLATLAND, FLATLAND} };
+    PathSampler<uint64_t> sampler(*grid, rows, cols);
+    assert(sampler.count() == uint64_t(countAllPaths(*grid, rows, cols)));
+    assert(sampler.count() == 19);
+
+    // the first 7 choices of a path pick it among the 2^7 step strings
+    std::vector<int> batch(size_t(numSamples) * sampler.length());
+    assert(sampler.sampleBatch(1, numSamples, batch.data(), 3));
+    std::vector<int> frequency(1 << (rows + cols - 2), 0);
+    for(int n = 0; n < numSamples; n++) {
+        const int* path = batch.data() + size_t(n) * sampler.length();
+        assert(isPath(path, *grid, rows, cols));
+        int steps = 0;
+        for(int k = 1; k < sampler.length(); k++) {
+            steps = (steps << 1) | (path[k] - path[k - 1] != 1);
+        }
+        frequency[steps]++;
+    }
+    int distinct = 0;
+    for(int f : frequency) {
+        if(f == 0) continue;
+        distinct++;
+        assert((f > 2000 - 220) && (f < 2000 + 220)); // 5 standard deviations, sqrt(2000 * 18 / 19) is about 44
+    }
+    assert(distinct == 19);
+
+    std::vector<int> single(batch.size());
+    assert(sampler.sampleBatch(1, numSamples, single.data(), 1));
+    assert(single == batch);
+
+    constexpr int bigRows = 40;
+    constexpr int bigCols = 40;
+    std::vector<CELLFLAG> open(bigRows * bigCols, FLATLAND);
+    PathSampler<BigCounter> big(open.data(), bigRows, bigCols);
+    assert(toString(big.count()) == toString(countAllPaths<BigCounter>(open.data(), bigRows, bigCols)));
+    std::mt19937_64 rng(2);
+    std::vector<int> path(big.length());
+    int firstDown = 0;
+    for(int n = 0; n < 2000; n++) {
+        assert(big.sample(rng, path.data()));
+        assert(isPath(path.data(), open.data(), bigRows, bigCols));
+        firstDown += (path[1] == bigCols);
+    }
+    assert((firstDown > 1000 * 8 / 10) && (firstDown < 1000 * 12 / 10));
+
+    grid[0][1] = SNAKE;
+    grid[1][0] = SNAKE;
+    assert(!PathSampler<uint64_t>(*grid, rows, cols).sample(rng, path.data()));
+}
+
+// Output
+//     a Rows * Columns grid without snakes, at compile time
+template<int Rows, int Columns>
+constexpr std::array<CELLFLAG, Rows * Columns> openGrid() {
+    std::array<CELLFLAG, Rows * Columns> grid{};
+    for(CELLFLAG& flag : grid) {
+        flag = FLATLAND;
+    }
+    return grid;
+}
+
+// the paths of the open square tiles, counted by the compiler
+constexpr uint64_t OPEN_TILE_PATHS[] = {
+    countAllPaths<4, 4, uint64_t>(openGrid<4, 4>().data()),
+    countAllPaths<8, 8, uint64_t>(openGrid<8, 8>().data()),
+    countAllPaths<16, 16, uint64_t>(openGrid<16, 16>().data()),
+};
+
+// This case will cover the compile-time sizes, counted by the compiler and dispatched at runtime,
+// against the runtime dynamic programming of the padded grid
+void testFixedSize() {
+    static_assert(OPEN_TILE_PATHS[0] == 20, "C(6, 3)");
+    static_assert(OPEN_TILE_PATHS[1] == 3432, "C(14, 7)");
+    static_assert(OPEN_TILE_PATHS[2] == 155117520, "C(30, 15)");
+    constexpr CELLFLAG snakes[3 * 4] = {
+        FLATLAND, FLATLAND, FLATLAND, FLATLAND,
+        FLATLAND, SNAKE,    FLATLAND, FLATLAND,
+        FLATLAND, FLATLAND, SNAKE,    FLATLAND
+    };
+    static_assert(countAllPaths<3, 4>(snakes) == 2, "around both snakes, leaving the top row at the third or the fourth column");
+    static_assert(countAllPaths<1, 1>(openGrid<1, 1>().data()) == 1, "the source is the destination");
+
+    for(int size : { 4, 8, 16 }) {
+        for(uint64_t seed = 0; seed < 20; seed++) {
+            std::vector<CELLFLAG> grid(size * size);
+            std::mt19937_64 rng(seed);
+            for(CELLFLAG& flag : grid) {
+                flag = (rng() % 8 == 0) ? SNAKE : FLATLAND;
+            }
+            grid.front() = FLATLAND;
+            grid.back() = FLATLAND;
+            const PaddedGrid padded(grid.data(), size, size);
+            assert(countAllPaths<int>(grid.data(), size, size) == countAllPaths<int>(padded));
+            assert(countAllPaths<uint64_t>(grid.data(), size, size) == countAllPaths<uint64_t>(padded));
+            assert(countAllPaths<ModCounter>(grid.data(), size, size) == countAllPaths<ModCounter>(padded));
+        }
+    }
+}
+
+// This case will cover grids of mixed sizes counted in batches, partial batches included,
+// by every batch kernel against the dynamic programming of every grid on its own
+void testBatchCounting() {
+    const int sizes[][2] = { { 1, 1 }, { 3, 5 }, { 8, 8 }, { 17, 9 }, { 40, 33 } };
+    std::vector<std::vector<CELLFLAG>> storage;
+    std::vector<GridRef> grids;
+    std::mt19937_64 rng(23);
+    for(int g = 0; g < 150; g++) {
+        const int rows = sizes[g % 5][0];
+        const int cols = sizes[g % 5][1];
+        std::vector<CELLFLAG> grid(rows * cols);
+        for(CELLFLAG& flag : grid) {
+            flag = (rng() % 10 == 0) ? SNAKE : FLATLAND;
+        }
+        grid.front() = FLATLAND;
+        grid.back() = FLATLAND;
+        storage.push_back(grid);
+    }
+    for(const std::vector<CELLFLAG>& grid : storage) {
+        const int g = int(grids.size());
+        grids.push_back(GridRef{ grid.data(), sizes[g % 5][0], sizes[g % 5][1] });
+    }
+
+    const rowkernel::Isa detected = rowkernel::detectedIsa();
+    for(int isa = rowkernel::SCALAR; isa <= detected; isa++) {
+        rowkernel::selectedIsa() = rowkernel::Isa(isa);
+        const std::vector<int> paths32 = countAllPathsBatched<int>(grids);
+        const std::vector<uint64_t> paths64 = countAllPathsBatched<uint64_t>(grids);
+        const std::vector<ModCounter> pathsMod = countAllPathsBatched<ModCounter>(grids);
+        for(size_t g = 0; g < grids.size(); g++) {
+            const PaddedGrid padded(grids[g].grid, grids[g].rows, grids[g].columns);
+            assert(paths32[g] == countAllPaths<int>(padded));
+            assert(paths64[g] == countAllPaths<uint64_t>(padded));
+            assert(pathsMod[g] == countAllPaths<ModCounter>(padded));
+        }
+    }
+    rowkernel::selectedIsa() = detected;
+}
+
+// Output
+//     the paths through every cell of the grid by row major order, the product of the full forward and backward
+//     dp tables, the reference of countPathsThrough
+std::vector<uint64_t> throughCounts(const CELLFLAG* grid, int rows, int columns) {
+    std::vector<uint64_t> forward(size_t(rows) * columns, 0);
+    std::vector<uint64_t> backward(size_t(rows) * columns, 0);
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < columns; j++) {
+            const size_t pos = size_t(i) * columns + j;
+            if(grid[pos] == SNAKE) continue;
+            forward[pos] = (i == 0 && j == 0) ? 1 : ((i > 0) ? forward[pos - columns] : 0) + ((j > 0) ? forward[pos - 1] : 0);
+        }
+    }
+    for(int i = rows - 1; i >= 0; i--) {
+        for(int j = columns - 1; j >= 0; j--) {
+            const size_t pos = size_t(i) * columns + j;
+            if(grid[pos] == SNAKE) continue;
+            backward[pos] = (i == rows - 1 && j == columns - 1) ? 1
+                          : ((i < rows - 1) ? backward[pos + columns] : 0) + ((j < columns - 1) ? backward[pos + 1] : 0);
+        }
+    }
+    for(size_t pos = 0; pos < forward.size(); pos++) {
+        forward[pos] *= backward[pos];
+    }
+    return forward;
+}
+
+// This case will cover the heatmap of random matrices for several tilings and threads, every cell must match the
+// product of the full dp tables, and every path crosses every anti-diagonal once
+void testHeatmap() {
+    constexpr int rows = 9; // C(157, 8) paths at most, uint64_t is exact
+    constexpr int cols = 150; // 3 tiles of 64 columns for the packed grid, the last one partial
+
+    std::mt19937_64 rng(24);
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = (rng() % 32 == 0) ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+    const std::vector<uint64_t> expected = throughCounts(grid.data(), rows, cols);
+    assert(expected[0] != 0);
+
+    char path[] = "/tmp/heatmap_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    const int tilings[][3] = { {1, 256, 2048}, {3, 4, 7}, {4, 1, 1}, {2, 9, 150} };
+    for(const auto& tiling : tilings) {
+        MappedHeatmap<uint64_t> heatmap;
+        assert(heatmap.create(path, rows, cols));
+        assert(countPathsThrough<uint64_t>(grid.data(), rows, cols, heatmap, tiling[0], tiling[1], tiling[2]) == expected[0]);
+        for(int i = 0; i < rows; i++) {
+            for(int j = 0; j < cols; j++) {
+                assert(heatmap.row(i)[j] == expected[size_t(i) * cols + j]);
+            }
+        }
+    }
+
+    PackedGrid packed(grid.data(), rows, cols);
+    {
+        MappedHeatmap<uint64_t> heatmap;
+        assert(heatmap.create(path, rows, cols));
+        assert(countPathsThrough<uint64_t>(packed.view(), heatmap, 3, 5, 64) == expected[0]);
+    }
+    MappedHeatmap<uint64_t> reopened;
+    assert(reopened.open(path));
+    assert((reopened.rows() == rows) && (reopened.columns() == cols));
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            assert(reopened.row(i)[j] == expected[size_t(i) * cols + j]);
+        }
+    }
+    MappedHeatmap<ModCounter> wrongCounter;
+    assert(!wrongCounter.open(path));
+
+    // tiles of 2 pages of counters per row, so the pages released by the backward pass are read back by the forward one
+    constexpr int openRows = 300;
+    constexpr int openCols = 5000;
+    std::vector<CELLFLAG> open(openRows * openCols, FLATLAND);
+    MappedHeatmap<ModCounter> heatmap;
+    assert(heatmap.create(path, openRows, openCols));
+    const ModCounter total = countPathsThrough(open.data(), openRows, openCols, heatmap, 4, 64, 2048);
+    assert(total == countAllPaths<ModCounter>(open.data(), openRows, openCols));
+    for(int d = 0; d < openRows + openCols - 1; d++) {
+        ModCounter crossing(0);
+        for(int i = std::max(0, d - openCols + 1); i <= std::min(d, openRows - 1); i++) {
+            crossing += heatmap.row(i)[d - i];
+        }
+        assert(crossing == total);
+    }
+    heatmap.close();
+    unlink(path);
+}
+
+// This case will cover a packed matrix streamed from a file and from a pipe, one row and many rows per chunk,
+// the number of paths must be the same as in memory, a truncated file must be reported and an idle pipe closed
+void testGridStream() {
+    constexpr int rows = 301;
+    constexpr int cols = 77;
+
+    std::mt19937_64 rng(26);
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = (rng() % 8 == 0) ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+    const uint64_t expected = countAllPaths<uint64_t>(grid.data(), rows, cols);
+    assert(expected != 0);
+
+    char path[] = "/tmp/grid_stream_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    PackedGrid packed(grid.data(), rows, cols);
+    assert(packed.write(path));
+
+    for(size_t chunkBytes : { size_t(1), size_t(1000), GridStream::CHUNK_BYTES }) {
+        GridStream stream;
+        assert(stream.open(path, chunkBytes));
+        assert((stream.rows() == rows) && (stream.columns() == cols));
+        uint64_t paths = 0;
+        assert(countAllPaths(stream, paths));
+        assert(paths == expected);
+        assert(stream.next().rows == 0);
+    }
+
+    std::vector<char> bytes;
+    {
+        FILE* file = fopen(path, "rb");
+        assert(file != nullptr);
+        for(int c = fgetc(file); c != EOF; c = fgetc(file)) {
+            bytes.push_back(char(c));
+        }
+        fclose(file);
+    }
+    int ends[2];
+    assert(pipe(ends) == 0);
+    std::thread writer([&] {
+        for(size_t done = 0; done < bytes.size(); ) {
+            const ssize_t n = write(ends[1], bytes.data() + done, std::min<size_t>(4096, bytes.size() - done));
+            assert(n > 0);
+            done += size_t(n);
+        }
+        close(ends[1]);
+    });
+    {
+        GridStream stream;
+        assert(stream.open(ends[0], 640));
+        ModCounter paths(0);
+        assert(countAllPaths(stream, paths));
+        assert(paths == countAllPaths<ModCounter>(grid.data(), rows, cols));
+    }
+    writer.join();
+    close(ends[0]);
+
+    // closed early while the writer of the pipe is still open and sends nothing more
+    assert(pipe(ends) == 0);
+    assert(write(ends[1], bytes.data(), sizeof(PackedGridHeader)) == ssize_t(sizeof(PackedGridHeader)));
+    {
+        GridStream stream;
+        assert(stream.open(ends[0], 640));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // the reader waits in the read of the rows
+        stream.close();
+    }
+    close(ends[1]);
+    close(ends[0]);
+
+    assert(truncate(path, off_t(bytes.size() - 8)) == 0);
+    {
+        GridStream stream;
+        assert(stream.open(path, 1000));
+        uint64_t paths = 0;
+        assert(!countAllPaths(stream, paths));
+        assert(stream.truncated());
+    }
+    assert(truncate(path, 10) == 0);
+    GridStream stream;
+    assert(!stream.open(path));
+    unlink(path);
+}
+
+#ifdef BENCHMARK
+#include<iostream>      // for cout
+#include "Benchmark.h" // for secondsOf, randomGrid, mazeGrid, BenchmarkReport
+
+// Synopsis
+//     print the cells per second of every counter policy against the 32-bit baseline. The paths of a grid large
+//     enough to be timed overflow every fixed width, so the baseline is uint32_t, which wraps, and not int,
+//     whose overflow is undefined
+void benchmarkCounterPolicies() {
+    constexpr int rows = 2000;
+    constexpr int cols = 2000;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 1);
+    const double cells = double(rows) * cols;
+
+    double baseline = 0;
+    auto run = [&](const char* name, auto counter) {
+        typedef decltype(counter) Counter;
+        double seconds = secondsOf([&] { doNotOptimize(countAllPaths<Counter>(grid.data(), rows, cols)); });
+        if(baseline == 0) baseline = seconds;
+        std::cout << name << ": " << cells / seconds / 1e6 << " Mcells/s, " << seconds / baseline << "x uint32_t" << std::endl;
+    };
+    run("uint32_t", uint32_t());
+    run("uint64_t", uint64_t());
+    run("uint128_t", uint128_t());
+    run("ModCounter", ModCounter());
+    run("BigCounter", BigCounter());
+}
+
+// Synopsis
+//     print the cells per second of the wavefront engine for 1, 2, 4, ... hardware threads and some tile sizes
+void benchmarkWavefront() {
+    constexpr int rows = 8000;
+    constexpr int cols = 8000;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 2);
+    const double cells = double(rows) * cols;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    double serial = secondsOf([&] { doNotOptimize(countAllPaths<ModCounter>(grid.data(), rows, cols)); });
+    std::cout << "serial: " << cells / serial / 1e6 << " Mcells/s" << std::endl;
+    const int tiles[][2] = { {64, 1024}, {256, 2048}, {1024, 4096} };
+    for(const auto& tile : tiles) {
+        for(int threads = 1; threads <= maxThreads; threads *= 2) {
+            double seconds = secondsOf([&] { doNotOptimize(countAllPathsWavefront<ModCounter>(grid.data(), rows, cols, threads, tile[0], tile[1])); });
+            std::cout << "wavefront " << tile[0] << "x" << tile[1] << " threads " << threads << ": "
+                      << cells / seconds / 1e6 << " Mcells/s, speedup " << serial / seconds << std::endl;
+        }
+    }
+}
+
+// Synopsis
+//     print the cells per second of the scalar, AVX2 and AVX-512 row kernels, for uint32_t, which wraps where
+//     int would overflow, and uint64_t
+void benchmarkRowKernels() {
+    constexpr int rows = 400;
+    constexpr int cols = 4000;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 3);
+    const double cells = double(rows) * cols;
+    const char* names[] = { "scalar", "avx2", "avx512" };
+
+    const rowkernel::Isa detected = rowkernel::detectedIsa();
+    for(int isa = rowkernel::SCALAR; isa <= detected; isa++) {
+        rowkernel::selectedIsa() = rowkernel::Isa(isa);
+        double seconds32 = secondsOf([&] { doNotOptimize(countAllPaths<uint32_t>(grid.data(), rows, cols)); });
+        double seconds64 = secondsOf([&] { doNotOptimize(countAllPaths<uint64_t>(grid.data(), rows, cols)); });
+        std::cout << "row kernel " << names[isa] << ": uint32_t " << cells / seconds32 / 1e6 << " Mcells/s, uint64_t "
+                  << cells / seconds64 / 1e6 << " Mcells/s" << std::endl;
+    }
+    rowkernel::selectedIsa() = detected;
+}
+
+// Synopsis
+//     print the cells per second of the CELLFLAG grid against the bit-packed grid
+void benchmarkPackedGrid() {
+    constexpr int rows = 4000;
+    constexpr int cols = 4000;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 4);
+    PackedGrid packed(grid.data(), rows, cols);
+    const double cells = double(rows) * cols;
+
+    double unpacked = secondsOf([&] { doNotOptimize(countAllPaths<uint32_t>(grid.data(), rows, cols)); });
+    double bits = secondsOf([&] { doNotOptimize(countAllPaths<uint32_t>(packed.view())); });
+    std::cout << "CELLFLAG grid: " << cells / unpacked / 1e6 << " Mcells/s, " << cells * sizeof(CELLFLAG) / 1e6 << " MB" << std::endl;
+    std::cout << "packed grid: " << cells / bits / 1e6 << " Mcells/s, " << cells / 8 / 1e6 << " MB" << std::endl;
+}
+
+// Synopsis
+//     print the latency of random single cell changes, incremental against full recount
+void benchmarkIncrementalCounter() {
+    constexpr int rows = 2000;
+    constexpr int cols = 2000;
+    constexpr int edits = 1000;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 9);
+    IncrementalCounter<ModCounter> counter(grid.data(), rows, cols);
+
+    std::mt19937_64 rng(10);
+    long long recomputed = 0;
+    double incremental = secondsOf([&] {
+        for(int edit = 0; edit < edits; edit++) {
+            recomputed += counter.toggleCell(1 + int(rng() % (rows - 2)), int(rng() % cols));
+        }
+        doNotOptimize(counter.count());
+    });
+    double full = secondsOf([&] { doNotOptimize(countAllPaths<ModCounter>(grid.data(), rows, cols)); });
+    std::cout << "incremental update: " << incremental / edits * 1e6 << " us, " << recomputed / edits << " cells; full recount: "
+              << full * 1e6 << " us, " << rows * cols << " cells" << std::endl;
+}
+
+// Synopsis
+//     print the paths per second of the sampler for every exact counter and 1, 2, 4, ... hardware threads
+void benchmarkPathSampler() {
+    constexpr long long numSamples = 100000;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    auto run = [&](const char* name, auto counter, int rows, int cols) {
+        typedef decltype(counter) Counter;
+        std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.02, 11);
+        PathSampler<Counter> sampler(grid.data(), rows, cols);
+        std::vector<int> paths(size_t(numSamples) * sampler.length());
+        for(int threads = 1; threads <= maxThreads; threads *= 2) {
+            double seconds = secondsOf([&] { sampler.sampleBatch(12, numSamples, paths.data(), threads); });
+            std::cout << name << " " << rows << "x" << cols << " threads " << threads << ": "
+                      << numSamples / seconds / 1e6 << " Msamples/s" << std::endl;
+        }
+    };
+    run("uint64_t", uint64_t(), 30, 30);
+    run("uint128_t", uint128_t(), 60, 60);
+    run("BigCounter", BigCounter(), 300, 300);
+}
+
+// Synopsis
+//     print the tiles per second of countAllPaths<Size, Size> and of the runtime dynamic programming of the padded
+//     grids over the same random Size * Size tiles
+template<int Size>
+void benchmarkFixedSizeOf() {
+    constexpr int numTiles = 1 << 14;
+    std::vector<std::vector<CELLFLAG>> tiles;
+    std::vector<PaddedGrid> padded;
+    for(int t = 0; t < numTiles; t++) {
+        tiles.push_back(randomGrid<CELLFLAG>(Size, Size, 0.1, t));
+        padded.emplace_back(tiles.back().data(), Size, Size);
+    }
+    uint64_t sum = 0;
+    const double fixed = secondsOf([&] {
+        for(const std::vector<CELLFLAG>& tile : tiles) {
+            sum += countAllPaths<Size, Size, uint64_t>(tile.data());
+        }
+    });
+    const double runtime = secondsOf([&] {
+        for(const PaddedGrid& tile : padded) {
+            sum -= countAllPaths<uint64_t>(tile);
+        }
+    });
+    assert(sum == 0);
+    std::cout << Size << "x" << Size << " tiles: compile-time size " << numTiles / fixed / 1e6 << " Mtiles/s, runtime size "
+              << numTiles / runtime / 1e6 << " Mtiles/s, speedup " << runtime / fixed << std::endl;
+}
+
+void benchmarkFixedSize() {
+    benchmarkFixedSizeOf<4>();
+    benchmarkFixedSizeOf<8>();
+    benchmarkFixedSizeOf<16>();
+    benchmarkFixedSizeOf<32>();
+}
+
+// Synopsis
+//     print the grids per second of countAllPaths one grid at a time, of the batch kernel on grids already in
+//     GridBatch bundles and of countAllPathsBatched from the CELLFLAG grids, over the same random grids of one size,
+//     for every batch kernel
+void benchmarkBatchCountingOf(int rows, int cols) {
+    constexpr int numGrids = 1 << 16;
+    std::vector<std::vector<CELLFLAG>> storage;
+    std::vector<GridRef> grids;
+    std::vector<GridBatch> bundles(numGrids / BATCH_LANES, GridBatch(rows, cols));
+    for(int g = 0; g < numGrids; g++) {
+        storage.push_back(randomGrid<CELLFLAG>(rows, cols, 0.1, g));
+        bundles[g / BATCH_LANES].add(storage.back().data());
+    }
+    for(std::vector<CELLFLAG>& grid : storage) {
+        grids.push_back(GridRef{ grid.data(), rows, cols });
+    }
+    const char* names[] = { "scalar", "avx2", "avx512" };
+    uint64_t single = 0;
+    const double seconds = secondsOf([&] {
+        for(std::vector<CELLFLAG>& grid : storage) {
+            single += countAllPaths<uint64_t>(grid.data(), rows, cols);
+        }
+    });
+    std::cout << rows << "x" << cols << " grids one at a time: " << numGrids / seconds / 1e6 << " Mgrids/s" << std::endl;
+    const rowkernel::Isa detected = rowkernel::detectedIsa();
+    for(int isa = rowkernel::SCALAR; isa <= detected; isa++) {
+        rowkernel::selectedIsa() = rowkernel::Isa(isa);
+        uint64_t bundled = 0;
+        const double bundleSeconds = secondsOf([&] {
+            uint64_t paths[BATCH_LANES];
+            for(const GridBatch& bundle : bundles) {
+                countAllPaths(bundle, paths);
+                for(uint64_t p : paths) {
+                    bundled += p;
+                }
+            }
+        });
+        uint64_t batched = 0;
+        const double batchSeconds = secondsOf([&] {
+            for(uint64_t paths : countAllPathsBatched<uint64_t>(grids)) {
+                batched += paths;
+            }
+        });
+        assert((bundled == single) && (batched == single));
+        std::cout << rows << "x" << cols << " grids, " << names[isa] << ": bundles " << numGrids / bundleSeconds / 1e6
+                  << " Mgrids/s, speedup " << seconds / bundleSeconds << ", batched " << numGrids / batchSeconds / 1e6
+                  << " Mgrids/s, speedup " << seconds / batchSeconds << std::endl;
+    }
+    rowkernel::selectedIsa() = detected;
+}
+
+void benchmarkBatchCounting() {
+    benchmarkBatchCountingOf(8, 8);
+    benchmarkBatchCountingOf(12, 20);
+    benchmarkBatchCountingOf(32, 32);
+}
+
+// Synopsis
+//     print the cells per second of the heatmap for 1, 2, 4, ... hardware threads against one count of the paths,
+//     and the peak resident set against the size of the heatmap file, the grid being packed so that it is small
+void benchmarkHeatmap() {
+    constexpr int rows = 4096;
+    constexpr int cols = 4096;
+    std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, 0.1, 25);
+    PackedGrid packed(grid.data(), rows, cols);
+    grid = std::vector<CELLFLAG>();
+    const double cells = double(rows) * cols;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    char path[] = "/tmp/heatmap_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    const double count = secondsOf([&] { doNotOptimize(countAllPaths<ModCounter>(packed.view())); });
+    std::cout << "count only: " << cells / count / 1e6 << " Mcells/s" << std::endl;
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        MappedHeatmap<ModCounter> heatmap;
+        if(!heatmap.create(path, rows, cols)) { // not inside assert, the benchmark may be built with NDEBUG
+            std::cout << "heatmap: cannot create " << path << std::endl;
+            break;
+        }
+        resetPeakRss();
+        const double seconds = secondsOf([&] { doNotOptimize(countPathsThrough(packed.view(), heatmap, threads)); });
+        std::cout << "heatmap threads " << threads << ": " << cells / seconds / 1e6 << " Mcells/s, "
+                  << seconds / count << "x count only, peak RSS " << peakRssKb() << " KiB for a "
+                  << cells * sizeof(ModCounter) / 1024 << " KiB heatmap" << std::endl;
+    }
+    unlink(path);
+}
+
+// Synopsis
+//     print the cells and bytes per second of a large packed grid counted from its file by GridStream, from a pipe
+//     fed by another thread, and mapped by MappedGrid, with the peak resident set of each; the grid is written
+//     to the file a row at a time, it is never in memory
+void benchmarkGridStream() {
+    constexpr int rows = 100000;
+    constexpr int cols = 10000;
+    const int wordsPerRow = packedWordsPerRow(cols);
+    const double cells = double(rows) * cols;
+    const double bytes = double(rows) * wordsPerRow * sizeof(uint64_t);
+
+    char path[] = "/tmp/grid_stream_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    {
+        FILE* file = fopen(path, "wb");
+        assert(file != nullptr);
+        PackedGridHeader header;
+        memcpy(header.magic, PACKED_GRID_MAGIC, sizeof(header.magic));
+        header.version = PACKED_GRID_VERSION;
+        header.rows = rows;
+        header.columns = cols;
+        fwrite(&header, sizeof(header), 1, file);
+        std::mt19937_64 rng(27);
+        std::vector<uint64_t> row(wordsPerRow);
+        for(int i = 0; i < rows; i++) {
+            for(uint64_t& word : row) {
+                word = ~(rng() & rng() & rng()); // a snake in 1 cell of 8
+            }
+            row.back() &= ~uint64_t(0) >> (64 * wordsPerRow - cols);
+            if(i == 0) row.front() |= 1;
+            if(i == rows - 1) row.back() |= uint64_t(1) << ((cols - 1) % 64);
+            fwrite(row.data(), sizeof(uint64_t), row.size(), file);
+        }
+        fclose(file);
+    }
+
+    auto report = [&](const char* name, double seconds) {
+        std::cout << name << ": " << cells / seconds / 1e6 << " Mcells/s, " << bytes / seconds / 1e6 << " MB/s, peak RSS "
+                  << peakRssKb() << " KiB for a " << bytes / 1024 << " KiB grid" << std::endl;
+    };
+    // the calls timed are not inside assert, the benchmark may be built with NDEBUG
+    auto failed = [&](const char* name) {
+        std::cout << name << ": the grid could not be counted" << std::endl;
+        unlink(path);
+    };
+    ModCounter streamed(0);
+    bool counted = false;
+    resetPeakRss();
+    double seconds = secondsOf([&] {
+        GridStream stream;
+        counted = stream.open(path) && countAllPaths(stream, streamed);
+    });
+    if(!counted) return failed("stream from file");
+    report("stream from file", seconds);
+
+    resetPeakRss();
+    seconds = secondsOf([&] {
+        int ends[2];
+        counted = false;
+        if(pipe(ends) != 0) return;
+        std::thread writer([&] {
+            int source = open(path, O_RDONLY);
+            std::vector<char> buffer(1 << 16);
+            for(ssize_t n = read(source, buffer.data(), buffer.size()); n > 0; n = read(source, buffer.data(), buffer.size())) {
+                for(ssize_t done = 0; done < n; ) {
+                    done += write(ends[1], buffer.data() + done, size_t(n - done));
+                }
+            }
+            close(source);
+            close(ends[1]);
+        });
+        GridStream stream;
+        ModCounter paths(0);
+        counted = stream.open(ends[0]) && countAllPaths(stream, paths) && (paths == streamed);
+        stream.close();
+        std::vector<char> rest(1 << 16); // what a failed count left in the pipe, so that the writer ends
+        while(read(ends[0], rest.data(), rest.size()) > 0) {}
+        writer.join();
+        close(ends[0]);
+    });
+    if(!counted) return failed("stream from pipe");
+    report("stream from pipe", seconds);
+
+    resetPeakRss();
+    seconds = secondsOf([&] {
+        MappedGrid mapped;
+        counted = mapped.open(path) && (countAllPaths<ModCounter>(mapped.view()) == streamed);
+    });
+    if(!counted) return failed("mapped file");
+    report("mapped file", seconds);
+    unlink(path);
+}
+
+// Synopsis
+//     the suite of Answer-A, see Benchmark.h: the dynamic programming on open, uniform and maze grids of growing
+//     size, and the wavefront on the largest uniform grid for 1, 2, 4, ... hardware threads
+void benchmarkSuite() {
+    BenchmarkReport report("Answer-A");
+    constexpr uint64_t seed = 20;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for(int size : { 255, 511, 1023, 2047, 4095 }) {
+        std::vector<CELLFLAG> open(size_t(size) * size, FLATLAND);
+        std::vector<CELLFLAG> uniform = randomGrid<CELLFLAG>(size, size, 0.1, seed);
+        std::vector<CELLFLAG> maze = mazeGrid<CELLFLAG>(size, size, 0.5, seed);
+        report.measure({ "countAllPaths<ModCounter>", "open", 0, size, size, 0, 1, false },
+                       [&] { return countAllPaths<ModCounter>(open.data(), size, size); });
+        report.measure({ "countAllPaths<ModCounter>", "uniform", seed, size, size, 0.1, 1, false },
+                       [&] { return countAllPaths<ModCounter>(uniform.data(), size, size); });
+        report.measure({ "countAllPaths<ModCounter>", "maze", seed, size, size, 0.5, 1, false },
+                       [&] { return countAllPaths<ModCounter>(maze.data(), size, size); });
+        report.measure({ "countAllPaths<uint64_t>", "uniform", seed, size, size, 0.1, 1, false },
+                       [&] { return countAllPaths<uint64_t>(uniform.data(), size, size); });
+        if(size != 4095) continue;
+        for(int threads = 1; threads <= maxThreads; threads *= 2) {
+            report.measure({ "countAllPathsWavefront<ModCounter>", "uniform", seed, size, size, 0.1, threads, false },
+                           [&] { return countAllPathsWavefront<ModCounter>(uniform.data(), size, size, threads); });
+        }
+    }
+}
+#endif
+
 int main() {
+#ifdef BENCHMARK
+    benchmarkCounterPolicies();
+    benchmarkWavefront();
+    benchmarkRowKernels();
+    benchmarkPackedGrid();
+    benchmarkIncrementalCounter();
+    benchmarkPathSampler();
+    benchmarkFixedSize();
+    benchmarkBatchCounting();
+    benchmarkHeatmap();
+    benchmarkGridStream();
+    benchmarkSuite();
+    return 0;
+#endif
     testZeroPath1(); // 0 path expected
     testZeroPath2(); // 0 path expected
     testZeroPath3(); // 0 path expected
@@ -135,5 +1671,17 @@ int main() {
     testFullPath();  // 6 paths expected
     testNumPathOfRectMatrix1(); // 1 path expected
     testNumPathOfRectMatrix2(); // 1 path expected
+    testCounterPolicies();      // C(34, 17) paths expected by every counter
+    testBigCounter();           // the same number of paths expected by every counter
+    testWavefront();            // the same number of paths expected as the serial one
+    testRowKernels();           // the same number of paths expected by every row kernel
+    testPackedGrid();           // the same number of paths expected from the packed grid
+    testPaddedGrid();           // the same number of paths expected from the padded grid
+    testIncrementalCounter();   // the same number of paths expected as a full recount
+    testPathSampler();          // every path expected with the same frequency
+    testFixedSize();            // the same number of paths expected from the compile-time sizes
+    testBatchCounting();        // the same number of paths expected from every lane of every batch
+    testHeatmap();              // the product of the forward and backward tables expected in every cell
+    testGridStream();           // the same number of paths expected from a file and a pipe
     return 0;
 }
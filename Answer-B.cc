@@ -5,14 +5,18 @@
 // The rabbit cannot move to a cell that has snakes.
 // In this program the different paths will be counted with K snakes.
 
-#include<utility> // for std::pair
-#include<cassert> // for assert
+#include<utility>   // for std::pair
+#include<cassert>   // for assert
+#include<vector>    // for std::vector
+#include<algorithm> // for std::sort, std::lower_bound
+#include<thread>    // for std::thread
+
+#include "PathCounter.h" // for the counter policies
+#include "RowKernel.h"   // for scanRow
+#include "Binomial.h"    // for BinomialTable, SparseBinomial, BlockedBinomial
+#include "Grid.h"        // for CELLFLAG
 
 typedef std::pair<int, int> Position;
-enum CELLFLAG {
-    SNAKE,
-    FLATLAND
-};
 
 // Input
 //     snakes      : the pointer which points to the Position of snakes, this Position starts from 0
@@ -23,7 +27,7 @@ enum CELLFLAG {
 //     Position(first, second) has snake or not
 // Synopsis
 //     traverse the snake array to determine the position(first, second) has snake or not
-inline CELLFLAG isSnake(Position* snakes, int num_snakes, int first, int second) {
+inline CELLFLAG isSnake(const Position* snakes, int num_snakes, int first, int second) {
     if(snakes == nullptr) return FLATLAND;
     
     for(int k = 0; k < num_snakes; k++) {
@@ -42,39 +46,136 @@ inline CELLFLAG isSnake(Position* snakes, int num_snakes, int first, int second)
 // Output
 //     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
 // Synopsis
-//     The total number of different paths is counted by iterative calculation
-int countAllPathsByStride(Position* snakes, int num_snakes, int major_order, int minor_order) {
-    int num_paths[major_order]; // store the intermediate result
+//     The total number of different paths is counted by iterative calculation,
+//     every stride is a segmented prefix sum computed by scanRow from RowKernel.h.
+//     The snakes are sorted by (minor, major) once and a cursor walks them in lock-step with the strides,
+//     so the flags of a stride cost O(major_order) plus its own snakes: O(rows * columns + K log K) in total.
+template<typename Counter>
+Counter countAllPathsByStride(const Position* snakes, int num_snakes, int major_order, int minor_order) {
+    std::vector<Counter> num_paths(major_order, Counter(0)); // store the intermediate result
+    std::vector<CELLFLAG> stride(major_order, FLATLAND);     // flags of the current stride
 
-    num_paths[0] = 1;
-    for(int i = 1; i < major_order; i++) { // process the first stride
-        if((num_paths[i - 1] == 1) && (isSnake(snakes, num_snakes, i, 0) == FLATLAND)) {
-            num_paths[i] = 1;
+    // snake index, sorted by (minor, major), snakes outside the grid are dropped
+    std::vector<Position> index;
+    index.reserve(num_snakes);
+    for(int k = 0; k < num_snakes; k++) {
+        if((snakes[k].first >= 0) && (snakes[k].first < major_order) && (snakes[k].second >= 0) && (snakes[k].second < minor_order)) {
+            index.push_back(snakes[k]);
         }
     }
+    std::sort(index.begin(), index.end(), [](const Position& a, const Position& b) {
+        return (a.second < b.second) || ((a.second == b.second) && (a.first < b.first));
+    });
+    const int num_indexed = int(index.size());
+    int cursor = 0;
+    int strideBegin = 0; // the first snake of the previous stride, to be cleared
 
-    for(int j = 1; j < minor_order; j++) {
-        // process the first cell
-        if((num_paths[0] == 1) && (isSnake(snakes, num_snakes, 0, j) == FLATLAND)) {
-            num_paths[0] = 1;
+    for(int j = 0; j < minor_order; j++) {
+        for(int k = strideBegin; k < cursor; k++) {
+            stride[index[k].first] = FLATLAND;
         }
-        else {
-            num_paths[0] = 0;
+        strideBegin = cursor;
+        for(; (cursor < num_indexed) && (index[cursor].second == j); cursor++) {
+            stride[index[cursor].first] = SNAKE;
         }
-        
-        for(int i = 1; i < major_order; i++) {
-            if(isSnake(snakes, num_snakes, i, j) == FLATLAND) {
-                num_paths[i] += num_paths[i - 1];
-            }
-            else {
-                num_paths[i] = 0;
+        // the source is reached from its virtual neighbour before the first stride
+        scanRow(num_paths.data(), stride.data(), major_order, Counter(j == 0 ? 1 : 0));
+    }
+
+    return num_paths[major_order - 1];
+}
+
+// Input
+//     sorted   : the snakes inside the grid, sorted by (first, second) and unique
+//     rows     : the number of rows
+//     columns  : the number of columns
+//     binomial : a BinomialTable, a prepared SparseBinomial or a BlockedBinomial, which answer paths()
+// Output
+//     the number of different paths modulo the prime of Counter
+// Synopsis
+//     paths[k], the number of paths from the source to snake k which meet no other snake, is
+//     C(source -> k) - sum of paths[l] * C(l -> k) for the snakes l before k,
+//     and the answer is C(source -> destination) - sum of paths[k] * C(k -> destination).
+template<typename Counter, typename Binomial>
+Counter countAllPathsBySortedSnakes(const std::vector<Position>& sorted, int rows, int columns, const Binomial& binomial) {
+    const int K = int(sorted.size());
+    std::vector<Counter> paths(K);
+    Counter result = binomial.paths(0, 0, rows - 1, columns - 1);
+    for(int k = 0; k < K; k++) {
+        Counter p = binomial.paths(0, 0, sorted[k].first, sorted[k].second);
+        for(int l = 0; l < k; l++) {
+            if(sorted[l].second <= sorted[k].second) { // sorted[l].first <= sorted[k].first by the order
+                p -= paths[l] * binomial.paths(sorted[l].first, sorted[l].second, sorted[k].first, sorted[k].second);
             }
         }
+        paths[k] = p;
+        result -= p * binomial.paths(sorted[k].first, sorted[k].second, rows - 1, columns - 1);
     }
+    return result;
+}
 
-    return num_paths[major_order - 1];
+// the largest rows + columns - 2 for which countAllPathsByBinomial and PreparedGrid keep the whole BinomialTable,
+// 128 MB of ModCounter; beyond it, or from the modulus on, they compute the factorials by Lucas' theorem
+constexpr int64_t BINOMIAL_TABLE_MAX_N = int64_t(1) << 24;
+
+// Output
+//     true if the BinomialTable of a rows x columns grid is below both BINOMIAL_TABLE_MAX_N and the modulus
+template<typename Counter>
+bool fitsBinomialTable(int rows, int columns) {
+    const int64_t maxN = int64_t(rows) + columns - 2;
+    return (maxN < int64_t(IsModCounter<Counter>::MODULUS)) && (maxN <= BINOMIAL_TABLE_MAX_N);
+}
+
+// Input
+//     snakes     : the pointer which points to the Position of snakes
+//     num_snakes : the number of snakes
+//     rows       : the number of rows
+//     columns    : the number of columns
+// Output
+//     the number of different paths modulo the prime of Counter, a MontgomeryCounter
+// Synopsis
+//     The snakes are sorted by (first, second), so a snake which can reach another one comes before it,
+//     and counted by countAllPathsBySortedSnakes in O(K^2) independent of rows * columns.
+//     The binomials come from a BinomialTable of O(rows + columns) when it is small, otherwise from a
+//     SparseBinomial, by Lucas' theorem, over the factorials of the O(K^2) pairs only, so that a
+//     1e9 x 1e9 grid, whose rows + columns - 2 exceeds the modulus, is counted as well.
+template<typename Counter>
+Counter countAllPathsByBinomial(const Position* snakes, int num_snakes, int rows, int columns) {
+    static_assert(IsModCounter<Counter>::value, "the combinatorial solver counts modulo a prime");
+
+    std::vector<Position> sorted;
+    sorted.reserve(num_snakes);
+    for(int k = 0; k < num_snakes; k++) { // snakes outside the grid are dropped
+        if((snakes[k].first >= 0) && (snakes[k].first < rows) && (snakes[k].second >= 0) && (snakes[k].second < columns)) {
+            sorted.push_back(snakes[k]);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    const int K = int(sorted.size());
+
+    if(fitsBinomialTable<Counter>(rows, columns)) {
+        const BinomialTable<Counter> binomial(rows + columns - 2);
+        return countAllPathsBySortedSnakes<Counter>(sorted, rows, columns, binomial);
+    }
+
+    // the same pairs as countAllPathsBySortedSnakes asks for
+    SparseBinomial<Counter> binomial;
+    binomial.needPaths(0, 0, rows - 1, columns - 1);
+    for(int k = 0; k < K; k++) {
+        binomial.needPaths(0, 0, sorted[k].first, sorted[k].second);
+        binomial.needPaths(sorted[k].first, sorted[k].second, rows - 1, columns - 1);
+        for(int l = 0; l < k; l++) {
+            binomial.needPaths(sorted[l].first, sorted[l].second, sorted[k].first, sorted[k].second);
+        }
+    }
+    binomial.prepare();
+    return countAllPathsBySortedSnakes<Counter>(sorted, rows, columns, binomial);
 }
 
+// relative cost of one snake pair of countAllPathsByBinomial against one cell of countAllPathsByStride
+constexpr double BINOMIAL_PAIR_COST = 4.0;
+
 // Input
 //     snakes     : the pointer which points to the Position of snakes
 //     num_snakes : the number of snakes
@@ -82,31 +183,191 @@ int countAllPathsByStride(Position* snakes, int num_snakes, int major_order, int
 //     columns    : the number of columns
 // Output
 //     the number of different paths from top-left-most cell to the bottom-right-most cell of the grid
+//     as Counter: int by default, or uint64_t, uint128_t, ModCounter and BigCounter from PathCounter.h
 // Synopsis
-//     traverse the matrix to calculate the number of paths according to the min(rows, columns)
-int countAllPaths(Position* snakes, int num_snakes, int rows, int columns) {
+//     traverse the matrix to calculate the number of paths according to the min(rows, columns),
+//     a counter modulo a prime goes to countAllPathsByBinomial instead when K^2 is cheaper than rows * columns
+template<typename Counter = int>
+Counter countAllPaths(const Position* snakes, int num_snakes, int rows, int columns) {
     assert(((snakes != nullptr) && (num_snakes != 0)) || ((snakes == nullptr) && (num_snakes == 0)));
     assert(isSnake(snakes, num_snakes, 0, 0) == FLATLAND);
     assert(isSnake(snakes, num_snakes, rows - 1, columns - 1) == FLATLAND);
 
-    int major_order = rows;
-    int minor_order = columns;
+    if constexpr(IsModCounter<Counter>::value) {
+        const double area = double(rows) * columns;
+        const double pairs = BINOMIAL_PAIR_COST * double(num_snakes) * num_snakes / 2 + double(rows) + columns;
+        if(area > pairs) {
+            return countAllPathsByBinomial<Counter>(snakes, num_snakes, rows, columns);
+        }
+    }
 
-    // column major default, for row major case, transpose the matrix to avoid duplicate code
+    // column major default, for row major case, transpose a copy of the snakes to avoid duplicate code,
+    // the caller's snakes stay untouched so that they can be shared
     if(rows > columns) {
+        std::vector<Position> transposed(num_snakes);
         for(int i = 0; i < num_snakes; i++) {
-            Position tmp;
-            tmp.swap(snakes[i]);
-            snakes[i].first = tmp.second;
-            snakes[i].second = tmp.first;
+            transposed[i] = Position(snakes[i].second, snakes[i].first);
         }
-        major_order = columns;
-        minor_order = rows;
+        return countAllPathsByStride<Counter>(transposed.data(), num_snakes, columns, rows);
     }
 
-    return countAllPathsByStride(snakes, num_snakes, major_order, minor_order);
+    return countAllPathsByStride<Counter>(snakes, num_snakes, rows, columns);
 }
 
+// path count query from source to destination, both inclusive
+struct PathQuery {
+    Position source;
+    Position destination;
+};
+
+// Grid prepared once from a snake set and shared read only by any number of queries and threads.
+// The snakes are sorted by (first, second) and the binomial tables are computed in the constructor,
+// a query only reads them, so the const member functions are thread-safe without locks.
+template<typename Counter = ModCounter>
+class PreparedGrid {
+    static_assert(IsModCounter<Counter>::value, "the prepared grid counts modulo a prime");
+
+public:
+    // Input
+    //     snakes     : the pointer which points to the Position of snakes, it is copied
+    //     num_snakes : the number of snakes
+    //     rows       : the number of rows
+    //     columns    : the number of columns
+    // Synopsis
+    //     the binomials come from a BinomialTable as in countAllPathsByBinomial, or from a BlockedBinomial when
+    //     rows + columns - 2 is beyond BINOMIAL_TABLE_MAX_N or the modulus, since the queries are not known yet
+    PreparedGrid(const Position* snakes, int num_snakes, int rows, int columns)
+        : rows(rows), columns(columns), tabled(fitsBinomialTable<Counter>(rows, columns)),
+          table(tabled ? rows + columns - 2 : 0), blocked(tabled ? 0 : int64_t(rows) + columns - 2) {
+        sorted.reserve(num_snakes);
+        for(int k = 0; k < num_snakes; k++) { // snakes outside the grid are dropped
+            if((snakes[k].first >= 0) && (snakes[k].first < rows) && (snakes[k].second >= 0) && (snakes[k].second < columns)) {
+                sorted.push_back(snakes[k]);
+            }
+        }
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    }
+
+    // Input
+    //     query : the source and the destination, both inside the grid
+    // Output
+    //     the number of different paths from the source to the destination, 0 if either has a snake
+    Counter countPaths(const PathQuery& query) const {
+        Scratch scratch;
+        return countPaths(query, scratch);
+    }
+
+    // Input
+    //     queries     : the queries
+    //     num_queries : the number of queries
+    //     results     : the number of paths of every query
+    //     numThreads  : the number of threads sharing the queries
+    // Synopsis
+    //     every thread answers a contiguous share of the queries with its own scratch buffers
+    void countPaths(const PathQuery* queries, int num_queries, Counter* results, int numThreads) const {
+        assert(numThreads > 0);
+        auto worker = [&](int begin, int end) {
+            Scratch scratch;
+            for(int q = begin; q < end; q++) {
+                results[q] = countPaths(queries[q], scratch);
+            }
+        };
+        std::vector<std::thread> workers;
+        const int share = (num_queries + numThreads - 1) / numThreads;
+        for(int t = 1; t < numThreads && t * share < num_queries; t++) {
+            workers.emplace_back(worker, t * share, std::min(num_queries, (t + 1) * share));
+        }
+        worker(0, std::min(num_queries, share));
+        for(std::thread& t : workers) {
+            t.join();
+        }
+    }
+
+private:
+    // per thread buffers, reused from one query to the next
+    struct Scratch {
+        std::vector<int> inside;      // indices of the snakes inside the query rectangle
+        std::vector<Counter> paths;   // per snake paths of the inclusion-exclusion, or the row of the dp
+    };
+
+    // Synopsis
+    //     The snakes inside the rectangle are a filtered slice of the sorted snakes.
+    //     The query is answered by inclusion-exclusion over them, like countAllPathsByBinomial,
+    //     or by a row by row dp over the rectangle when the rectangle is smaller than K^2.
+    Counter countPaths(const PathQuery& query, Scratch& scratch) const {
+        const Position& src = query.source;
+        const Position& dst = query.destination;
+        assert((src.first >= 0) && (src.second >= 0) && (dst.first < rows) && (dst.second < columns));
+        if((dst.first < src.first) || (dst.second < src.second)) return Counter(0);
+
+        scratch.inside.clear();
+        auto begin = std::lower_bound(sorted.begin(), sorted.end(), src);
+        auto end = std::upper_bound(begin, sorted.end(), dst);
+        for(auto it = begin; it != end; ++it) {
+            if((it->second >= src.second) && (it->second <= dst.second)) {
+                scratch.inside.push_back(int(it - sorted.begin()));
+            }
+        }
+        const int K = int(scratch.inside.size());
+        if((K > 0) && ((sorted[scratch.inside.front()] == src) || (sorted[scratch.inside.back()] == dst))) {
+            return Counter(0);
+        }
+
+        const int height = dst.first - src.first + 1;
+        const int width = dst.second - src.second + 1;
+        if(double(height) * width <= BINOMIAL_PAIR_COST * double(K) * K / 2) {
+            std::vector<Counter>& num_paths = scratch.paths;
+            num_paths.assign(width, Counter(0));
+            int cursor = 0;
+            for(int i = 0; i < height; i++) {
+                Counter left = Counter(i == 0 ? 1 : 0);
+                for(int j = 0; j < width; j++) {
+                    num_paths[j] += left;
+                    if((cursor < K) && (sorted[scratch.inside[cursor]] == Position(src.first + i, src.second + j))) {
+                        num_paths[j] = Counter(0);
+                        cursor++;
+                    }
+                    left = num_paths[j];
+                }
+            }
+            return num_paths[width - 1];
+        }
+
+        return tabled ? countPathsBy(table, src, dst, scratch) : countPathsBy(blocked, src, dst, scratch);
+    }
+
+    // Synopsis
+    //     the inclusion-exclusion over the snakes in scratch.inside, see countAllPathsBySortedSnakes
+    template<typename Binomial>
+    Counter countPathsBy(const Binomial& binomial, const Position& src, const Position& dst, Scratch& scratch) const {
+        const int K = int(scratch.inside.size());
+        std::vector<Counter>& paths = scratch.paths;
+        paths.resize(K);
+        Counter result = binomial.paths(src.first, src.second, dst.first, dst.second);
+        for(int k = 0; k < K; k++) {
+            const Position& sk = sorted[scratch.inside[k]];
+            Counter p = binomial.paths(src.first, src.second, sk.first, sk.second);
+            for(int l = 0; l < k; l++) {
+                const Position& sl = sorted[scratch.inside[l]];
+                if(sl.second <= sk.second) {
+                    p -= paths[l] * binomial.paths(sl.first, sl.second, sk.first, sk.second);
+                }
+            }
+            paths[k] = p;
+            result -= p * binomial.paths(sk.first, sk.second, dst.first, dst.second);
+        }
+        return result;
+    }
+
+    const int rows;
+    const int columns;
+    std::vector<Position> sorted;
+    const bool tabled; // table is used, otherwise blocked, the other one is empty
+    const BinomialTable<Counter> table;
+    const BlockedBinomial<Counter> blocked;
+};
+
 // This case will cover the 3*3 matrix with 3 snake
 void testZeroPath1() {
     constexpr int K = 3;
@@ -183,7 +444,330 @@ void testNumPathOfRectMatrix2() {
     assert(countAllPaths(snakes, K, rows, columns) == result);
 }
 
+// This case will cover the 18*18 matrix with 1 snake, whose number of paths is beyond int
+void testCounterPolicies() {
+    constexpr int K = 1;
+    Position snakes[K] = { Position(0, 17) };
+    constexpr int rows = 18;
+    constexpr int columns = 18;
+    const char* result = "2333606219"; // C(34, 17) - 1
+
+    assert(toString(countAllPaths<uint64_t>(snakes, K, rows, columns)) == result);
+    assert(toString(countAllPaths<uint128_t>(snakes, K, rows, columns)) == result);
+    assert(countAllPaths<ModCounter>(snakes, K, rows, columns).value() == 2333606219ull % 998244353);
+    assert(toString(countAllPaths<BigCounter>(snakes, K, rows, columns)) == result);
+}
+
+// This case will cover the 23*41 and 41*23 matrices with unsorted and duplicated snakes,
+// compared with the dynamic programming which scans the snakes for every cell
+void testSnakeIndex() {
+    constexpr int K = 120;
+    constexpr int rows = 23;
+    constexpr int columns = 41;
+    Position snakes[K];
+    for(int k = 0; k < K; k++) {
+        unsigned h = unsigned(k * 2654435761u);
+        snakes[k] = Position(1 + int(h % (rows - 2)), int((h >> 8) % columns)); // never on the first and last row
+    }
+
+    uint64_t reference[rows][columns];
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < columns; j++) {
+            uint64_t up = (i > 0) ? reference[i - 1][j] : 0;
+            uint64_t left = (j > 0) ? reference[i][j - 1] : ((i == 0) ? 1 : 0);
+            reference[i][j] = (isSnake(snakes, K, i, j) == FLATLAND) ? up + left : 0;
+        }
+    }
+    assert(reference[rows - 1][columns - 1] != 0);
+    assert(countAllPaths<uint64_t>(snakes, K, rows, columns) == reference[rows - 1][columns - 1]);
+    for(int k = 0; k < K; k++) { // the transposed matrix has the same number of paths
+        snakes[k] = Position(snakes[k].second, snakes[k].first);
+    }
+    assert(countAllPaths<uint64_t>(snakes, K, columns, rows) == reference[rows - 1][columns - 1]);
+}
+
+// This case will cover random matrices and snakes, the combinatorial solver must agree with the stride solver
+void testBinomial() {
+    for(int seed = 0; seed < 20; seed++) {
+        const int rows = 2 + seed % 7 * 5;
+        const int columns = 3 + seed * 3;
+        const int K = seed * 4;
+        std::vector<Position> snakes;
+        for(int k = 0; k < K; k++) {
+            unsigned h = unsigned((seed * 1000 + k) * 2654435761u);
+            Position snake(int(h % rows), int((h >> 8) % columns));
+            if((snake != Position(0, 0)) && (snake != Position(rows - 1, columns - 1))) {
+                snakes.push_back(snake);
+                snakes.push_back(snake); // duplicated
+            }
+        }
+        Position* data = snakes.empty() ? nullptr : snakes.data();
+        const int num = int(snakes.size());
+        const ModCounter expected = countAllPathsByStride<ModCounter>(data, num, rows, columns);
+        assert(countAllPathsByBinomial<ModCounter>(data, num, rows, columns) == expected);
+        assert(countAllPaths<ModCounter>(data, num, rows, columns) == expected);
+    }
+}
+
+// This case will cover the 1e6*1e6 matrix with 1 or 2 snakes, only the combinatorial solver can afford it
+void testHugeGrid() {
+    constexpr int rows = 1000000;
+    constexpr int columns = 1000000;
+
+    Position walls[2] = { Position(rows - 1, columns - 2), Position(rows - 2, columns - 1) };
+    assert(countAllPaths<ModCounter>(walls, 2, rows, columns) == ModCounter(0));
+
+    // with a snake on the right of the source, every path goes downwards first
+    Position right[1] = { Position(0, 1) };
+    const BinomialTable<ModCounter> binomial(rows + columns);
+    assert(countAllPaths<ModCounter>(right, 1, rows, columns) == binomial.paths(1, 0, rows - 1, columns - 1));
+}
+
+// This case will cover the 1e9*1e9 matrix, whose 2e9 - 2 steps exceed the modulus, by Lucas' theorem:
+// the paths avoiding the cell right of the source and those avoiding the cell below it make up all the paths
+void testGiantGrid() {
+    constexpr int rows = 1000000000;
+    constexpr int columns = 1000000000;
+
+    Position right[1] = { Position(0, 1) };
+    Position below[1] = { Position(1, 0) };
+    const ModCounter all = countAllPaths<ModCounter>(nullptr, 0, rows, columns);
+    assert(all != ModCounter(0));
+    assert(countAllPaths<ModCounter>(right, 1, rows, columns) + countAllPaths<ModCounter>(below, 1, rows, columns) == all);
+
+    Position walls[2] = { Position(rows - 1, columns - 2), Position(rows - 2, columns - 1) };
+    assert(countAllPaths<ModCounter>(walls, 2, rows, columns) == ModCounter(0));
+}
+
+// This case will cover Lucas' theorem modulo a small prime, the grids being several times the prime
+void testLucas() {
+    typedef MontgomeryCounter<101> SmallCounter;
+    for(int seed = 0; seed < 10; seed++) {
+        const int rows = 40 + seed * 23;
+        const int columns = 250 - seed * 11;
+        std::vector<Position> snakes;
+        for(int k = 0; k < seed * 5; k++) {
+            unsigned h = unsigned((seed * 1000 + k) * 2654435761u);
+            Position snake(int(h % rows), int((h >> 8) % columns));
+            if((snake != Position(0, 0)) && (snake != Position(rows - 1, columns - 1))) {
+                snakes.push_back(snake);
+            }
+        }
+        Position* data = snakes.empty() ? nullptr : snakes.data();
+        const int num = int(snakes.size());
+        assert(countAllPathsByBinomial<SmallCounter>(data, num, rows, columns)
+            == countAllPathsByStride<SmallCounter>(data, num, rows, columns));
+    }
+
+    SparseBinomial<SmallCounter> sparse;
+    for(int n = 0; n < 300; n++) {
+        for(int k = 0; k <= n; k++) sparse.need(n, k);
+    }
+    sparse.prepare();
+    std::vector<SmallCounter> pascal(1, SmallCounter(1)); // row n of Pascal's triangle
+    for(int n = 0; n < 300; n++) {
+        for(int k = 0; k <= n; k++) {
+            assert(sparse.choose(n, k) == pascal[k]);
+        }
+        pascal.push_back(SmallCounter(0));
+        for(int k = n + 1; k > 0; k--) {
+            pascal[k] += pascal[k - 1];
+        }
+    }
+}
+
+// This case will cover random queries on a shared snake set, answered in batch by 1 and 4 threads
+void testPreparedGrid() {
+    constexpr int rows = 60;
+    constexpr int columns = 45;
+    std::vector<Position> snakes;
+    for(int k = 0; k < 300; k++) {
+        unsigned h = unsigned(k * 2654435761u);
+        snakes.push_back(Position(int(h % rows), int((h >> 8) % columns)));
+    }
+    const PreparedGrid<ModCounter> grid(snakes.data(), int(snakes.size()), rows, columns);
+
+    std::vector<PathQuery> queries;
+    std::vector<ModCounter> expected;
+    for(int q = 0; q < 400; q++) {
+        unsigned h = unsigned((q + 7777) * 2246822519u);
+        Position src(int(h % rows), int((h >> 6) % columns));
+        Position dst(src.first + int((h >> 12) % (rows - src.first)), src.second + int((h >> 20) % (columns - src.second)));
+        queries.push_back(PathQuery{ src, dst });
+
+        // the sub-rectangle as a grid of its own
+        std::vector<Position> local;
+        bool blocked = false;
+        for(const Position& s : snakes) {
+            if((s.first >= src.first) && (s.first <= dst.first) && (s.second >= src.second) && (s.second <= dst.second)) {
+                local.push_back(Position(s.first - src.first, s.second - src.second));
+                blocked = blocked || (s == src) || (s == dst);
+            }
+        }
+        const int height = dst.first - src.first + 1;
+        const int width = dst.second - src.second + 1;
+        expected.push_back(blocked ? ModCounter(0)
+                                   : countAllPathsByStride<ModCounter>(local.empty() ? nullptr : local.data(), int(local.size()), height, width));
+    }
+
+    std::vector<ModCounter> results(queries.size());
+    for(int threads = 1; threads <= 4; threads += 3) {
+        grid.countPaths(queries.data(), int(queries.size()), results.data(), threads);
+        assert(results == expected);
+    }
+    assert(grid.countPaths(queries[0]) == expected[0]);
+
+    // the snakes are not transposed in place any more
+    Position few[2] = { Position(3, 1), Position(1, 4) };
+    assert(countAllPaths(few, 2, 9, 5) == 266);
+    assert((few[0] == Position(3, 1)) && (few[1] == Position(1, 4)));
+}
+
+// This case will cover queries on a shared 1e9*1e9 snake set, whose binomials go past the modulus, and on a grid
+// several times a small prime, each query against the sub-rectangle counted as a grid of its own. The snakes and
+// the ends of the queries are in the two 64*64 corners, small queries in the top-left one and large ones across
+void testPreparedGiantGrid() {
+    auto check = [](auto counter, int rows, int columns, int numSnakes, int numQueries) {
+        typedef decltype(counter) Counter;
+        auto corner = [&](unsigned h, bool far) {
+            const Position near(int(h % 64), int((h >> 8) % 64));
+            return far ? Position(rows - 1 - near.first, columns - 1 - near.second) : near;
+        };
+        std::vector<Position> snakes;
+        for(int k = 0; k < numSnakes; k++) {
+            snakes.push_back(corner(unsigned(k * 2654435761u), k % 2 == 1));
+        }
+        const PreparedGrid<Counter> grid(snakes.data(), numSnakes, rows, columns);
+        for(int q = 0; q < numQueries; q++) {
+            const unsigned h = unsigned((q + 99) * 2246822519u);
+            const Position a = corner(h, false);
+            const Position b = corner(h >> 16, q % 2 == 1);
+            const Position src(std::min(a.first, b.first), std::min(a.second, b.second));
+            const Position dst(std::max(a.first, b.first), std::max(a.second, b.second));
+            std::vector<Position> local;
+            bool blocked = false;
+            for(const Position& s : snakes) {
+                if((s.first >= src.first) && (s.first <= dst.first) && (s.second >= src.second) && (s.second <= dst.second)) {
+                    local.push_back(Position(s.first - src.first, s.second - src.second));
+                    blocked = blocked || (s == src) || (s == dst);
+                }
+            }
+            const Counter expected = blocked ? Counter(0)
+                : countAllPaths<Counter>(local.empty() ? nullptr : local.data(), int(local.size()),
+                                         dst.first - src.first + 1, dst.second - src.second + 1);
+            assert(grid.countPaths(PathQuery{ src, dst }) == expected);
+        }
+    };
+    check(ModCounter(), 1000000000, 1000000000, 60, 40);
+    check(MontgomeryCounter<101>(), 300, 250, 200, 40);
+}
+
+#ifdef BENCHMARK
+#include<iostream>      // for cout
+#include "Benchmark.h" // for secondsOf, randomSnakes, BenchmarkReport
+
+// Synopsis
+//     print the cells per second of the indexed stride solver for K from 0 to 1e6 snakes,
+//     and of the scan of the snakes for every cell while it is still affordable
+void benchmarkSnakeIndex() {
+    constexpr int rows = 2000;
+    constexpr int columns = 2000;
+    const double cells = double(rows) * columns;
+
+    for(int K = 0; K <= 1000000; K = (K == 0) ? 1 : K * 10) {
+        std::vector<Position> snakes = randomSnakes(rows, columns, K, 5);
+        Position* data = (K == 0) ? nullptr : snakes.data();
+        double seconds = secondsOf([&] { doNotOptimize(countAllPathsByStride<uint64_t>(data, K, rows, columns)); });
+        std::cout << "K " << K << ": indexed " << cells / seconds / 1e6 << " Mcells/s";
+        if(K <= 100) {
+            double scan = secondsOf([&] {
+                uint64_t found = 0;
+                for(int j = 0; j < columns; j++) {
+                    for(int i = 0; i < rows; i++) {
+                        found += isSnake(data, K, i, j);
+                    }
+                }
+                doNotOptimize(found);
+            });
+            std::cout << ", scan of the snakes alone " << cells / scan / 1e6 << " Mcells/s";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Synopsis
+//     print the seconds of the stride solver, the combinatorial solver and the dispatcher for growing K
+void benchmarkBinomial() {
+    constexpr int rows = 4000;
+    constexpr int columns = 4000;
+
+    for(int K = 10; K <= 10000; K *= 10) {
+        std::vector<Position> snakes = randomSnakes(rows, columns, K, 6);
+        double stride = secondsOf([&] { doNotOptimize(countAllPathsByStride<ModCounter>(snakes.data(), K, rows, columns)); });
+        double binomial = secondsOf([&] { doNotOptimize(countAllPathsByBinomial<ModCounter>(snakes.data(), K, rows, columns)); });
+        double dispatched = secondsOf([&] { doNotOptimize(countAllPaths<ModCounter>(snakes.data(), K, rows, columns)); });
+        std::cout << "K " << K << ": stride " << stride << " s, binomial " << binomial << " s, dispatched " << dispatched << " s" << std::endl;
+    }
+}
+
+// Synopsis
+//     print the queries per second of a prepared grid for 1, 2, 4, ... hardware threads
+void benchmarkPreparedGrid() {
+    constexpr int rows = 100000;
+    constexpr int columns = 100000;
+    constexpr int K = 2000;
+    constexpr int numQueries = 20000;
+    std::vector<Position> snakes = randomSnakes(rows, columns, K, 7);
+    const PreparedGrid<ModCounter> grid(snakes.data(), K, rows, columns);
+
+    std::mt19937_64 rng(8);
+    std::vector<PathQuery> queries(numQueries);
+    for(PathQuery& q : queries) {
+        q.source = Position(int(rng() % (rows / 2)), int(rng() % (columns / 2)));
+        q.destination = Position(q.source.first + int(rng() % (rows / 2)), q.source.second + int(rng() % (columns / 2)));
+    }
+    std::vector<ModCounter> results(numQueries);
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        double seconds = secondsOf([&] { grid.countPaths(queries.data(), numQueries, results.data(), threads); });
+        std::cout << "prepared grid threads " << threads << ": " << numQueries / seconds << " queries/s" << std::endl;
+    }
+}
+
+// Synopsis
+//     the suite of Answer-B, see Benchmark.h: the stride solver on square grids of growing size with a snake
+//     for every 1000 cells, and the binomial solver and the dispatch on a 100000*100000 grid with growing snake lists
+void benchmarkSuite() {
+    BenchmarkReport report("Answer-B");
+    constexpr uint64_t seed = 20;
+    for(int size : { 1024, 2048, 4096, 8192, 16384 }) {
+        const int K = int(int64_t(size) * size / 1000);
+        const std::vector<Position> snakes = randomSnakes(size, size, K, seed);
+        report.measure({ "countAllPathsByStride<ModCounter>", "snakes", seed, size, size, 0.001, 1, false },
+                       [&] { return countAllPathsByStride<ModCounter>(snakes.data(), K, size, size); });
+        report.measure({ "countAllPathsByStride<uint64_t>", "snakes", seed, size, size, 0.001, 1, false },
+                       [&] { return countAllPathsByStride<uint64_t>(snakes.data(), K, size, size); });
+    }
+    constexpr int size = 100000;
+    for(int K : { 500, 1000, 2000, 4000 }) {
+        const std::vector<Position> snakes = randomSnakes(size, size, K, seed);
+        const double density = double(K) / size / size;
+        report.measure({ "countAllPathsByBinomial<ModCounter>", "snakes", seed, size, size, density, 1, false },
+                       [&] { return countAllPathsByBinomial<ModCounter>(snakes.data(), K, size, size); });
+        report.measure({ "countAllPaths<ModCounter>", "snakes", seed, size, size, density, 1, false },
+                       [&] { return countAllPaths<ModCounter>(snakes.data(), K, size, size); });
+    }
+}
+#endif
+
 int main() {
+#ifdef BENCHMARK
+    benchmarkSnakeIndex();
+    benchmarkBinomial();
+    benchmarkPreparedGrid();
+    benchmarkSuite();
+    return 0;
+#endif
     testZeroPath1(); // 0 path expected
     testZeroPath2(); // 0 path expected
     testZeroPath3(); // 0 path expected
@@ -191,5 +775,13 @@ int main() {
     testFullPath();  // 6 path expected
     testNumPathOfRectMatrix1(); // 1 path expected
     testNumPathOfRectMatrix2(); // 1 path expected
+    testCounterPolicies();      // C(34, 17) - 1 paths expected by every counter
+    testSnakeIndex();           // the same number of paths expected as the scan of the snakes
+    testBinomial();             // the same number of paths expected by both solvers
+    testHugeGrid();             // 0 path expected when the destination is walled in
+    testGiantGrid();            // the paths on both sides of the source expected to make up all the paths
+    testLucas();                // the same number of paths expected modulo a small prime
+    testPreparedGrid();         // the same number of paths expected as a grid of its own
+    testPreparedGiantGrid();    // the same number of paths expected as a grid of its own past the modulus
     return 0;
 }
@@ -5,13 +5,27 @@
 // The rabbit cannot move to a cell that has snakes.
 // In this program the different paths will be printed.
 
-#include<cassert>  // for assert
-#include<iostream> // for cout
+#include<cassert>   // for assert
+#include<fstream>   // for std::ofstream, std::ifstream
+#include<iostream>  // for cout
+#include<sstream>   // for std::stringstream
+#include<vector>    // for std::vector
+#include<cstdint>   // for uint8_t
+#include<algorithm> // for std::min, std::max
+#include<atomic>    // for std::atomic
+#include<deque>     // for std::deque
+#include<map>       // for std::map
+#include<memory>    // for std::unique_ptr
+#include<mutex>     // for std::mutex
+#include<set>       // for std::set
+#include<thread>    // for std::thread
+#include<sys/wait.h> // for waitpid
 
-enum CELLFLAG {
-    SNAKE,
-    FLATLAND
-};
+#include "Checkpoint.h" // for CheckpointWriter, SearchState
+#include "Grid.h"       // for CELLFLAG, PaddedGrid
+#include "PackedGrid.h" // for PackedGridView, PackedGrid, MappedGrid
+#include "PathSink.h"   // for TextPathSink, BinaryPathSink, NullPathSink
+#include "SearchStats.h" // for SearchStats, CountingSearchStats
 
 enum VISITEDFLAG {
     UNVISITED,
@@ -19,60 +33,54 @@ enum VISITEDFLAG {
 };
 
 struct Cell {
-    int  pos;
-    char adj; // bit 0 for rightwards and bit 1 for downwards; 1 represents forward available and 0 for blocked
+    int  pos;  // the cell index by row major order, the one the sinks read
+    int  cell; // the index of the same cell in the PaddedGrid
+    char adj;  // bit 0 for rightwards and bit 1 for downwards; 1 represents forward available and 0 for blocked
 };
 
 constexpr int STEP = 1;
 
 // Input
-//     grid      : the pointer which points to the matrix by row major order
+//     grid      : the padded matrix, see Grid.h
 //     paths     : the pointer which points to the array which store the nodes in the path
 //     cellIndex : the cell to be reset
-//     rows      : the number of matrix rows
-//     columns   : the number of matrix columns
 // Output
 //     available towards of paths[cellIndex].adj
 // Synopsis
-//     reset the avaliable towards(rightwards & downwards) of the cell which is in cellIndex
-inline void resetCellAdj(CELLFLAG* grid, Cell* paths, int cellIndex, int rows, int columns) {
-    const int dstCell = rows * columns - STEP;
-    paths[cellIndex].adj = 0;
-    int rightwards = paths[cellIndex].pos + STEP;
-    int downwards = paths[cellIndex].pos + columns;
-    if(((rightwards % columns) != 0) && (rightwards <= dstCell) && (grid[rightwards] != SNAKE)) { // rightwards available
-        paths[cellIndex].adj |= 0x01;
-    }
-    
-    if((downwards <= dstCell) && (grid[downwards] != SNAKE)) { // downwards available
-        paths[cellIndex].adj |= 0x02;
-    }
+//     reset the avaliable towards(rightwards & downwards) of the cell which is in cellIndex,
+//     the SNAKE border stands for the edges of the matrix
+inline void resetCellAdj(const PaddedGrid& grid, Cell* paths, int cellIndex) {
+    const int cell = paths[cellIndex].cell;
+    paths[cellIndex].adj = char((grid[cell + STEP] != SNAKE) | ((grid[cell + grid.stride()] != SNAKE) << 1));
 }
 
 // Input
-//     gridName  : the name of grid
-//     grid      : the pointer which points to the matrix by row major order
-//     rows      : the number of matrix rows
-//     columns   : the number of matrix columns
+//     sink          : the PathSink which receives every path, see PathSink.h
+//     grid          : the padded matrix, see Grid.h
+//     numExpansions : if not null, the number of cells pushed into the stack
+//     checkpoint    : if not null, the writer the stack is offered to, see Checkpoint.h
+//     resume        : if not null, the checkpoint of an earlier run on the same grid to go on from
+//     stats         : if not null, the counters of the search are added to it, see SearchStats.h
 // Output
-//     number of correct paths
+//     number of correct paths, those before the checkpoint resumed included
 // Synopsis
-//     print all paths from top-left-most cell to the bottom-right-most cell which move rightwards or downwards (no diagonal movement) and do so one cell at a time
-int printAllPaths(const char* gridName, CELLFLAG* grid, int rows, int columns) {
+//     depth first search of all paths from top-left-most cell to the bottom-right-most cell which move rightwards or downwards,
+//     every branch which hits a snake wall is explored and backtracked
+template<typename Sink, typename Stats = SearchStats>
+int searchAllPaths(Sink& sink, const PaddedGrid& grid, long long* numExpansions = nullptr,
+                   CheckpointWriter* checkpoint = nullptr, const SearchState* resume = nullptr, Stats* stats = nullptr) {
     constexpr int EMPTYSTACK = -1;
+    const int rows = grid.rows();
+    const int columns = grid.columns();
+    const int down = grid.stride();
+    const int dstCell = grid.destination();
     int numPaths = 0;
-    const int dstCell = rows * columns - 1;
-    VISITEDFLAG vis[rows * columns];
-    for(int i = 0; i < (rows * columns); i++) {
-        vis[i] = UNVISITED;
-    }
+    long long expansions = 1; // the source
+    Stats local;
+    std::vector<VISITEDFLAG> vis(grid.size(), UNVISITED);
 
     // treat paths as stack
-    Cell paths[rows * columns];
-    for(int i = 0; i < (rows * columns); i++) {
-        paths[i].pos = 0;
-        paths[i].adj = 0;
-    }
+    std::vector<Cell> paths(size_t(rows) * columns);
     int curStep = EMPTYSTACK;
     
     // move to next position in stack
@@ -80,52 +88,549 @@ int printAllPaths(const char* gridName, CELLFLAG* grid, int rows, int columns) {
     
     // push source cell into stack at curStep
     paths[curStep].pos = 0;
-    resetCellAdj(grid, paths, 0, rows, columns);
+    paths[curStep].cell = grid.source();
+    resetCellAdj(grid, paths.data(), 0);
+    local.push(0);
+
+    if(resume != nullptr) { // the stack of the checkpoint, its cells are visited
+        assert((resume->rows == rows) && (resume->columns == columns));
+        curStep = int(resume->pos.size()) - 1;
+        for(int k = 0; k <= curStep; k++) {
+            paths[k].pos = resume->pos[k];
+            paths[k].cell = grid.cellOf(resume->pos[k]);
+            paths[k].adj = char(resume->adj[k]);
+            vis[paths[k].cell] = VISITED;
+            if(k > 0) local.push(k);
+        }
+        numPaths = int(resume->numPaths);
+        expansions = resume->expansions;
+    }
 
     while(curStep >= 0) { // until stack empty
-		const int curPos = paths[curStep].pos;
-        const int rightwards = curPos + STEP;
-        const int downwards  = curPos + columns;
-        if((curPos == dstCell)) { // print path
-            if((++numPaths) == 1) {
-                std::cout << "paths of function " << gridName << ": " << std::endl;
-            }
-            for(int i = 0; i < curStep; i++) {
-                std::cout << paths[i].pos << " -> ";
-            }
-            std::cout << paths[curStep].pos << std::endl;
-            vis[curPos] = UNVISITED;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+        if((checkpoint != nullptr) && checkpoint->due(expansions)) { // the paths counted are out before the state
+            checkpoint->offer(paths.data(), curStep + 1, rows, columns, numPaths, expansions, sink.sync());
+        }
+        Cell& cur = paths[curStep];
+        if(cur.cell == dstCell) { // emit path
+            numPaths++;
+            sink.path(paths.data(), curStep + 1);
+            local.pop(curStep, [] { return BACKTRACK_DESTINATION; });
+            vis[cur.cell] = UNVISITED;
             curStep--; // pop from stack
         }
-		// move rightwards
-        else if(((rightwards % columns) != 0) && (rightwards <= dstCell) && (grid[rightwards] != SNAKE) && (vis[rightwards] == UNVISITED) && ((paths[curStep].adj & 0x01) == 1)) {
-            paths[curStep].adj &= 0xFE;
-            vis[curPos] = VISITED;
+        // move rightwards
+        else if(((cur.adj & 0x01) != 0) && (vis[cur.cell + STEP] == UNVISITED)) {
+            cur.adj &= 0xFE;
+            vis[cur.cell] = VISITED;
             // push rightwards cell into stack at curStep
             curStep++;
-            paths[curStep].pos = rightwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+            expansions++;
+            local.push(curStep);
+            paths[curStep].pos = cur.pos + STEP;
+            paths[curStep].cell = cur.cell + STEP;
+            resetCellAdj(grid, paths.data(), curStep);
         }
-		// move downwards
-        else if((downwards <= dstCell) && (grid[downwards] != SNAKE) && (vis[downwards] == UNVISITED) && ((paths[curStep].adj & 0x02) != 0)) {
-            paths[curStep].adj &= 0xFD;
-            vis[curPos] = VISITED;
+        // move downwards
+        else if(((cur.adj & 0x02) != 0) && (vis[cur.cell + down] == UNVISITED)) {
+            cur.adj &= 0xFD;
+            vis[cur.cell] = VISITED;
             // push downwards cell into stack at curStep
             curStep++;
-            paths[curStep].pos = downwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+            expansions++;
+            local.push(curStep);
+            paths[curStep].pos = cur.pos + columns;
+            paths[curStep].cell = cur.cell + down;
+            resetCellAdj(grid, paths.data(), curStep);
         }
         else { // blocked, backtrack
-            vis[curPos] = UNVISITED;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+            local.pop(curStep, [&] { return (cur.adj != 0) ? BACKTRACK_VISITED : BACKTRACK_BLOCKED; });
+            vis[cur.cell] = UNVISITED;
             curStep--; // pop from stack
         }
     }
     
+    sink.finish();
+    if(checkpoint != nullptr) { // the search is over, a resume from here emits nothing
+        checkpoint->offer(paths.data(), 0, rows, columns, numPaths, expansions, sink.sync(), true);
+    }
+    if(numExpansions != nullptr) {
+        *numExpansions = expansions;
+    }
+    if(stats != nullptr) {
+        stats->merge(local);
+    }
     return numPaths;
 }
 
+// Input
+//     sink          : the PathSink which receives every path, see PathSink.h
+//     grid          : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows          : the number of matrix rows
+//     columns       : the number of matrix columns
+//     numExpansions : if not null, the number of cells pushed into the stack
+//     checkpoint    : if not null, the writer the stack is offered to, see Checkpoint.h
+//     resume        : if not null, the checkpoint of an earlier run on the same grid to go on from
+//     stats         : if not null, the counters of the search are added to it, see SearchStats.h
+// Output
+//     number of correct paths, those before the checkpoint resumed included
+// Synopsis
+//     the search above on the PaddedGrid of the matrix
+template<typename Sink, typename Grid, typename Stats = SearchStats>
+int searchAllPaths(Sink& sink, Grid grid, int rows, int columns, long long* numExpansions = nullptr,
+                   CheckpointWriter* checkpoint = nullptr, const SearchState* resume = nullptr, Stats* stats = nullptr) {
+    return searchAllPaths(sink, PaddedGrid(grid, rows, columns), numExpansions, checkpoint, resume, stats);
+}
+
+// Input
+//     grid      : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows      : the number of matrix rows
+//     columns   : the number of matrix columns
+// Output
+//     the PaddedGrid whose cell is FLATLAND if the cell is FLATLAND and can reach the bottom-right-most cell, SNAKE otherwise
+// Synopsis
+//     one backward sweep from the destination, like the dynamic programming of Answer-A in reverse:
+//     reach[i][j] = FLATLAND && (reach[i][j+1] || reach[i+1][j]), the SNAKE border reaching nothing
+template<typename Grid>
+PaddedGrid reverseReachability(Grid grid, int rows, int columns) {
+    PaddedGrid reach(grid, rows, columns);
+    const int dstCell = reach.destination();
+    for(int i = rows - 1; i >= 0; i--) {
+        for(int j = columns - 1; j >= 0; j--) {
+            const int cell = reach.cell(i, j);
+            if((cell == dstCell) || (reach[cell] == SNAKE)) continue;
+            reach[cell] = ((reach[cell + STEP] != SNAKE) || (reach[cell + reach.stride()] != SNAKE)) ? FLATLAND : SNAKE;
+        }
+    }
+    return reach;
+}
+
+// Input
+//     sink          : the PathSink which receives every path, see PathSink.h
+//     grid          : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows          : the number of matrix rows
+//     columns       : the number of matrix columns
+//     numExpansions : if not null, the number of cells pushed into the stack
+//     checkpoint    : if not null, the writer the stack is offered to, see Checkpoint.h
+//     resume        : if not null, the checkpoint of an earlier run on the same grid to go on from
+//     stats         : if not null, the counters of the search are added to it, see SearchStats.h
+// Output
+//     number of correct paths, those before the checkpoint resumed included
+// Synopsis
+//     enumerate all paths from top-left-most cell to the bottom-right-most cell which move rightwards or downwards (no diagonal movement) and do so one cell at a time.
+//     The search runs on the reverse reachability instead of the grid, a cell which cannot reach the destination
+//     looks like a snake, so every push leads to at least one path and there is no dead end:
+//     the work is O(total length of the paths emitted) after the O(rows * columns) sweep.
+template<typename Sink, typename Grid, typename Stats = SearchStats>
+int enumerateAllPaths(Sink& sink, Grid grid, int rows, int columns, long long* numExpansions = nullptr,
+                      CheckpointWriter* checkpoint = nullptr, const SearchState* resume = nullptr, Stats* stats = nullptr) {
+    const PaddedGrid reach = reverseReachability(grid, rows, columns);
+    if(reach[reach.source()] == SNAKE) { // no path at all
+        sink.finish();
+        if(numExpansions != nullptr) {
+            *numExpansions = 0;
+        }
+        return 0;
+    }
+    return searchAllPaths(sink, reach, numExpansions, checkpoint, resume, stats);
+}
+
+// Input
+//     sink    : the PathSink which receives every path below the prefix
+//     reach   : the reverse reachability of the matrix, see reverseReachability
+//     paths   : the stack, paths[0 .. depth - 1] is the prefix and it has room for a whole path
+//     depth   : the length of the prefix, whose last cell can reach the destination
+//     stats   : the counters of the search, the last cell of the prefix counted as pushed, see SearchStats.h
+// Output
+//     number of paths below the prefix
+// Synopsis
+//     the depth first search of searchAllPaths which never pops the prefix.
+//     A monotone path never comes back to a cell, so there is no visited flag
+template<typename Sink, typename Stats>
+long long searchSubtree(Sink& sink, const PaddedGrid& reach, Cell* paths, int depth, Stats& stats) {
+    long long numPaths = 0;
+    const int columns = reach.columns();
+    const int down = reach.stride();
+    const int dstCell = reach.destination();
+    int curStep = depth - 1;
+    resetCellAdj(reach, paths, curStep);
+    stats.push(curStep);
+    while(curStep >= depth - 1) {
+        Cell& cur = paths[curStep];
+        if(cur.cell == dstCell) { // emit path
+            numPaths++;
+            sink.path(paths, curStep + 1);
+            stats.pop(curStep, [] { return BACKTRACK_DESTINATION; });
+            curStep--;
+        }
+        else if((cur.adj & 0x01) != 0) { // move rightwards
+            cur.adj &= 0xFE;
+            paths[++curStep] = Cell{ cur.pos + STEP, cur.cell + STEP, 0 };
+            resetCellAdj(reach, paths, curStep);
+            stats.push(curStep);
+        }
+        else if((cur.adj & 0x02) != 0) { // move downwards
+            cur.adj &= 0xFD;
+            paths[++curStep] = Cell{ cur.pos + columns, cur.cell + down, 0 };
+            resetCellAdj(reach, paths, curStep);
+            stats.push(curStep);
+        }
+        else { // both done, backtrack
+            stats.pop(curStep, [] { return BACKTRACK_BLOCKED; });
+            curStep--;
+        }
+    }
+    return numPaths;
+}
+
+// A subtree of the search: every path which starts with prefix
+struct PathTask {
+    std::vector<int> prefix; // the cells of the PaddedGrid
+};
+
+// The tasks of one worker, the owner pushes and pops at the back and the thieves steal at the front,
+// where the oldest and shallowest task holds the largest subtree
+struct PathTaskQueue {
+    std::mutex lock;
+    std::deque<PathTask> tasks;
+};
+
+// Input
+//     sinkAt     : sinkAt(t) is the PathSink of worker t, or the only sink at sinkAt(0) if ordered
+//     grid       : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows       : the number of matrix rows
+//     columns    : the number of matrix columns
+//     numThreads : the number of worker threads
+//     ordered    : if true every path goes to sinkAt(0) in the order of enumerateAllPaths
+//     splitDepth : a task whose prefix is shorter is split into its one or two children instead of being searched
+//     stats      : if not null, the counters of the subtrees searched are added to it, see SearchStats.h
+// Output
+//     number of correct paths
+// Synopsis
+//     the search of enumerateAllPaths cut into subtrees. The first worker starts from the source; a worker pops
+//     the task at the back of its own queue and splits it, or searches it if its prefix is splitDepth cells long,
+//     and an idle worker steals the front task of another queue.
+//     Unordered, worker t writes its paths straight to sinkAt(t), and every sink is finished at the end.
+//     Ordered, every searched subtree is kept in its own MemoryPathSink and replayed into sinkAt(0) as soon as no
+//     task before it by prefix is left, a rightwards step coming before a downwards one in the prefixes as in the
+//     paths. Only the subtrees finished ahead of the first unfinished one are held, a few per thief in practice
+//     since the owners search the earliest tasks, but a stolen subtree may wait for the whole one before it.
+//     Every worker counts in its own Stats, merged after they join
+template<typename SinkAt, typename Grid, typename Stats = SearchStats>
+long long enumerateAllPathsParallel(SinkAt&& sinkAt, Grid grid, int rows, int columns, int numThreads,
+                                    bool ordered = false, int splitDepth = 12, Stats* stats = nullptr) {
+    assert(numThreads > 0);
+    const PaddedGrid reach = reverseReachability(grid, rows, columns);
+    const int pathLength = rows + columns - 1;
+    const int dstCell = reach.destination();
+    std::unique_ptr<PathTaskQueue[]> queues(new PathTaskQueue[numThreads]);
+    std::atomic<long long> outstanding(0); // the tasks pushed and not done yet
+    std::atomic<long long> numPaths(0);
+    // ordered only: the prefixes of the tasks pushed and not searched yet, and the subtrees waiting for them
+    std::mutex replayLock;
+    std::set<std::vector<int>> unfinished;
+    std::map<std::vector<int>, MemoryPathSink> finished;
+    std::vector<Stats> locals(numThreads);
+
+    if(reach[reach.source()] != SNAKE) {
+        queues[0].tasks.push_back(PathTask{ std::vector<int>(1, reach.source()) });
+        outstanding = 1;
+        if(ordered) unfinished.insert(queues[0].tasks.back().prefix);
+    }
+
+    auto popOrSteal = [&](int self, PathTask& task) {
+        for(int k = 0; k < numThreads; k++) {
+            PathTaskQueue& queue = queues[(self + k) % numThreads];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            if(queue.tasks.empty()) continue;
+            if(k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    auto worker = [&](int self) {
+        std::vector<Cell> paths(pathLength);
+        long long found = 0;
+        Stats counted; // on the stack of the worker, not next to the counters of another one
+        PathTask task;
+        while(outstanding.load() > 0) {
+            if(!popOrSteal(self, task)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int depth = int(task.prefix.size());
+            const int last = task.prefix.back();
+            if((depth < splitDepth) && (last != dstCell)) {
+                // push the downwards child first, so the rightwards one is popped first by the owner
+                const bool right = (reach[last + STEP] != SNAKE);
+                const bool down = (reach[last + reach.stride()] != SNAKE);
+                PathTask children[2];
+                int numChildren = 0;
+                for(int child : { down ? last + reach.stride() : -1, right ? last + STEP : -1 }) {
+                    if(child < 0) continue;
+                    children[numChildren].prefix = task.prefix;
+                    children[numChildren].prefix.push_back(child);
+                    numChildren++;
+                }
+                if(ordered) { // the children hold back the replay before they can be popped
+                    std::lock_guard<std::mutex> lock(replayLock);
+                    for(int c = 0; c < numChildren; c++) {
+                        unfinished.insert(children[c].prefix);
+                    }
+                    unfinished.erase(task.prefix);
+                }
+                PathTaskQueue& queue = queues[self];
+                std::lock_guard<std::mutex> lock(queue.lock);
+                for(int c = 0; c < numChildren; c++) {
+                    queue.tasks.push_back(std::move(children[c]));
+                    outstanding++;
+                }
+            }
+            else {
+                for(int i = 0; i < depth; i++) {
+                    paths[i].pos = reach.posOf(task.prefix[i]);
+                    paths[i].cell = task.prefix[i];
+                }
+                if(ordered) {
+                    MemoryPathSink buffer(columns);
+                    found += searchSubtree(buffer, reach, paths.data(), depth, counted);
+                    std::lock_guard<std::mutex> lock(replayLock);
+                    unfinished.erase(task.prefix);
+                    finished.emplace(std::move(task.prefix), std::move(buffer));
+                    // every later task descends from an unfinished one and its prefix is past it
+                    while(!finished.empty() && (unfinished.empty() || (finished.begin()->first < *unfinished.begin()))) {
+                        finished.begin()->second.replay(sinkAt(0));
+                        finished.erase(finished.begin());
+                    }
+                }
+                else {
+                    found += searchSubtree(sinkAt(self), reach, paths.data(), depth, counted);
+                }
+            }
+            outstanding--;
+        }
+        numPaths += found;
+        locals[self] = counted;
+    };
+
+    std::vector<std::thread> workers;
+    for(int t = 1; t < numThreads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for(std::thread& t : workers) {
+        t.join();
+    }
+    if(stats != nullptr) {
+        for(const Stats& local : locals) {
+            stats->merge(local);
+        }
+    }
+
+    if(ordered) {
+        assert(unfinished.empty() && finished.empty());
+        sinkAt(0).finish();
+    }
+    else {
+        for(int t = 0; t < numThreads; t++) {
+            sinkAt(t).finish();
+        }
+    }
+    return numPaths.load();
+}
+
+// Ranks of the paths in the order of enumerateAllPaths, where a rightwards step comes before a downwards one.
+// count[c] is the number of paths from the cell c of the PaddedGrid to the destination, the dynamic programming
+// of Answer-A run backwards, zero on the border; the paths whose first step is rightwards are the count[c + 1]
+// first ones from c.
+class PathRanker {
+public:
+    // Input
+    //     grid    : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    // Synopsis
+    //     the number of paths must fit in uint64_t, e.g. an open grid with rows + columns up to 68
+    template<typename Grid>
+    PathRanker(Grid grid, int rows, int columns) : padded(grid, rows, columns), count(padded.size(), 0) {
+        const int dstCell = padded.destination();
+        count[dstCell] = (padded[dstCell] != SNAKE);
+        for(int i = rows - 1; i >= 0; i--) {
+            for(int j = columns - 1; j >= 0; j--) {
+                const int cell = padded.cell(i, j);
+                if((cell == dstCell) || (padded[cell] == SNAKE)) continue;
+                const bool overflow = __builtin_add_overflow(rightwards(cell), downwards(cell), &count[cell]);
+                assert(!overflow);
+                (void)overflow;
+            }
+        }
+    }
+
+    uint64_t numPaths() const { return count[padded.source()]; }
+
+    // every path has the same number of cells
+    int length() const { return padded.rows() + padded.columns() - 1; }
+
+    // Input
+    //     k    : the rank, below numPaths()
+    //     path : the array of length() cells to be written
+    // Synopsis
+    //     O(rows + columns): step rightwards while k is among the paths which start rightwards
+    void unrank(uint64_t k, PathCell* path) const {
+        assert(k < numPaths());
+        path[0].pos = 0;
+        for(int i = 1, cell = padded.source(); i < length(); i++) {
+            if(k < rightwards(cell)) {
+                path[i].pos = path[i - 1].pos + STEP;
+                cell += STEP;
+            }
+            else {
+                k -= rightwards(cell);
+                path[i].pos = path[i - 1].pos + padded.columns();
+                cell += padded.stride();
+            }
+        }
+    }
+
+    // Input
+    //     path : the cells of a path of the grid
+    // Output
+    //     the rank of the path, the paths starting rightwards being skipped at every downwards step
+    uint64_t rank(const PathCell* path) const {
+        uint64_t k = 0;
+        for(int i = 1, cell = padded.source(); i < length(); i++) {
+            if(path[i].pos != path[i - 1].pos + STEP) {
+                k += rightwards(cell);
+                cell += padded.stride();
+            }
+            else {
+                cell += STEP;
+            }
+        }
+        return k;
+    }
+
+    // Input
+    //     path : the cells of a path of the grid, overwritten by the next path
+    // Output
+    //     false if path is the last path
+    // Synopsis
+    //     the last rightwards step which can be downwards instead turns downwards, and the rest of the path
+    //     becomes the first one from there
+    bool next(PathCell* path) const {
+        for(int i = length() - 2, cell = padded.destination(); i >= 0; i--) {
+            const bool right = (path[i + 1].pos == path[i].pos + STEP);
+            cell -= right ? STEP : padded.stride(); // the cell of path[i]
+            if(right && (downwards(cell) != 0)) {
+                path[i + 1].pos = path[i].pos + padded.columns();
+                cell += padded.stride();
+                for(int j = i + 2; j < length(); j++) {
+                    if(rightwards(cell) != 0) {
+                        path[j].pos = path[j - 1].pos + STEP;
+                        cell += STEP;
+                    }
+                    else {
+                        path[j].pos = path[j - 1].pos + padded.columns();
+                        cell += padded.stride();
+                    }
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    // the number of paths from the cell whose first step is rightwards, or downwards
+    uint64_t rightwards(int cell) const { return count[cell + STEP]; }
+    uint64_t downwards(int cell) const { return count[cell + padded.stride()]; }
+
+    PaddedGrid padded;
+    std::vector<uint64_t> count;
+};
+
+// Resumable forward iterator over the paths, from any rank
+class PathCursor {
+public:
+    // Input
+    //     ranker : the ranks of the grid, it must outlive the cursor
+    //     first  : the rank of the first path, the cursor is past the end if it is numPaths()
+    PathCursor(const PathRanker& ranker, uint64_t first) : ranker(ranker), current(first), cells(ranker.length()) {
+        if(valid()) ranker.unrank(first, cells.data());
+    }
+
+    bool valid() const { return current < ranker.numPaths(); }
+    uint64_t rank() const { return current; }
+    const PathCell* path() const { return cells.data(); }
+    int length() const { return ranker.length(); }
+
+    void next() {
+        if(ranker.next(cells.data())) current++;
+        else current = ranker.numPaths();
+    }
+
+private:
+    const PathRanker& ranker;
+    uint64_t current;
+    std::vector<PathCell> cells;
+};
+
+// Input
+//     sink   : the PathSink which receives the paths
+//     ranker : the ranks of the grid
+//     first  : the rank of the first path to be emitted
+//     last   : one past the rank of the last path to be emitted
+// Output
+//     number of paths emitted
+// Synopsis
+//     the shard [first, last) of enumerateAllPaths, without any state shared with the other shards
+template<typename Sink>
+uint64_t enumeratePathRange(Sink& sink, const PathRanker& ranker, uint64_t first, uint64_t last) {
+    last = std::min(last, ranker.numPaths());
+    uint64_t numPaths = 0;
+    for(PathCursor cursor(ranker, first); cursor.valid() && (cursor.rank() < last); cursor.next()) {
+        sink.path(cursor.path(), cursor.length());
+        numPaths++;
+    }
+    sink.finish();
+    return numPaths;
+}
+
+// Input
+//     gridName  : the name of grid
+//     grid      : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows      : the number of matrix rows
+//     columns   : the number of matrix columns
+// Output
+//     number of correct paths
+// Synopsis
+//     print all paths from top-left-most cell to the bottom-right-most cell which move rightwards or downwards (no diagonal movement) and do so one cell at a time
+template<typename Grid>
+int printAllPaths(const char* gridName, Grid grid, int rows, int columns) {
+    TextPathSink sink(gridName, std::cout);
+    return enumerateAllPaths(sink, grid, rows, columns);
+}
+
+// Input
+//     gridName  : the name of grid
+//     grid      : the bit-packed matrix, e.g. the view of a MappedGrid
+// Output
+//     number of correct paths
+// Synopsis
+//     the same search as above; the bits are expanded into the PaddedGrid the search runs on, one CELLFLAG per
+//     cell, which is the same order of memory as the visited flags and the stack of the search itself,
+//     so a mapped grid is not searched in place
+int printAllPaths(const char* gridName, const PackedGridView& grid) {
+    return printAllPaths(gridName, grid, grid.rows, grid.columns);
+}
+
 // This case will cover the 3*3 matrix with 3 snakes
 void testZeroPath1() {
     constexpr int rows = 3;
@@ -196,7 +701,569 @@ void testNumPathOfRectMatrix2() {
     assert(printAllPaths(__FUNCTION__, *grid, rows, cols) == result);
 }
 
+// This case will cover the 3*3 matrix with 1 snake, bit-packed in memory and mapped from a file
+void testPackedGrid() {
+    constexpr int rows = 3;
+    constexpr int cols = 3;
+    constexpr int result = 2;
+
+    CELLFLAG grid[rows][cols] = { {FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, SNAKE, FLATLAND}, {FLATLAND, FLATLAND, FLATLAND} };
+    PackedGrid packed(*grid, rows, cols);
+    assert(printAllPaths(__FUNCTION__, packed.view()) == result);
+
+    char path[] = "/tmp/packed_grid_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    assert(packed.write(path));
+    MappedGrid mapped;
+    assert(mapped.open(path));
+    assert(printAllPaths(__FUNCTION__, mapped.view()) == result);
+    mapped.close();
+    unlink(path);
+}
+
+// This case will cover the 3*3 matrix with 1 snake, written by the binary sink and counted by the null sink
+void testPathSinks() {
+    constexpr int rows = 3;
+    constexpr int cols = 3;
+    constexpr int result = 3;
+
+    CELLFLAG grid[rows][cols] = { {FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, FLATLAND, SNAKE}, {FLATLAND, FLATLAND, FLATLAND} };
+    std::stringstream binary;
+    BinaryPathSink binarySink(rows, cols, binary);
+    assert(enumerateAllPaths(binarySink, *grid, rows, cols) == result);
+    const std::vector<std::vector<int>> expected = { {0, 1, 4, 7, 8}, {0, 3, 4, 7, 8}, {0, 3, 6, 7, 8} };
+    assert(readBinaryPaths(binary) == expected);
+
+    std::stringstream text;
+    TextPathSink textSink(__FUNCTION__, text);
+    assert(enumerateAllPaths(textSink, *grid, rows, cols) == result);
+    assert(text.str() == "paths of function testPathSinks: \n0 -> 1 -> 4 -> 7 -> 8\n0 -> 3 -> 4 -> 7 -> 8\n0 -> 3 -> 6 -> 7 -> 8\n");
+
+    NullPathSink nullSink;
+    assert(enumerateAllPaths(nullSink, *grid, rows, cols) == result);
+    assert(nullSink.numPaths == result);
+}
+
+// This case will cover a 12*12 matrix full of dead ends, the pruned search must find the same paths
+// without pushing any cell which is not on a path
+void testDeadEndPruning() {
+    constexpr int rows = 12;
+    constexpr int cols = 12;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int i = 0; i < rows * cols; i++) {
+        grid[i] = ((i * 2654435761u) >> 28) < 3 ? SNAKE : FLATLAND;
+    }
+    grid[0] = FLATLAND;
+    grid[rows * cols - 1] = FLATLAND;
+
+    std::stringstream pruned, unpruned;
+    BinaryPathSink prunedSink(rows, cols, pruned);
+    BinaryPathSink unprunedSink(rows, cols, unpruned);
+    long long prunedExpansions = 0;
+    long long unprunedExpansions = 0;
+    const int numPaths = enumerateAllPaths(prunedSink, grid.data(), rows, cols, &prunedExpansions);
+    assert(numPaths > 0);
+    assert(searchAllPaths(unprunedSink, grid.data(), rows, cols, &unprunedExpansions) == numPaths);
+    assert(pruned.str() == unpruned.str());
+    assert(prunedExpansions < unprunedExpansions);
+    assert(prunedExpansions <= (long long)numPaths * (rows + cols - 1));
+
+    grid[1] = SNAKE;
+    grid[cols] = SNAKE;
+    NullPathSink nullSink;
+    assert(enumerateAllPaths(nullSink, grid.data(), rows, cols, &prunedExpansions) == 0);
+    assert(prunedExpansions == 0);
+}
+
+// This case will cover a 7*7 matrix with 4 snakes searched by 4 workers with small tasks,
+// the unordered sinks must count every path once and the ordered output must be the serial one
+void testParallelEnumeration() {
+    constexpr int rows = 7;
+    constexpr int cols = 7;
+    constexpr int numThreads = 4;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int pos : { 9, 17, 24, 38 }) {
+        grid[pos] = SNAKE;
+    }
+    std::stringstream serial;
+    BinaryPathSink serialSink(rows, cols, serial);
+    const int result = enumerateAllPaths(serialSink, grid.data(), rows, cols);
+    assert(result > 0);
+
+    for(int splitDepth : { 1, 3, 20 }) {
+        std::vector<NullPathSink> nullSinks(numThreads);
+        assert(enumerateAllPathsParallel([&](int t) -> NullPathSink& { return nullSinks[t]; },
+                                         grid.data(), rows, cols, numThreads, false, splitDepth) == result);
+        long long numPaths = 0;
+        for(const NullPathSink& sink : nullSinks) {
+            numPaths += sink.numPaths;
+        }
+        assert(numPaths == result);
+
+        std::stringstream ordered;
+        BinaryPathSink orderedSink(rows, cols, ordered);
+        assert(enumerateAllPathsParallel([&](int) -> BinaryPathSink& { return orderedSink; },
+                                         grid.data(), rows, cols, numThreads, true, splitDepth) == result);
+        assert(ordered.str() == serial.str());
+    }
+
+    grid[1] = SNAKE;
+    grid[cols] = SNAKE;
+    NullPathSink nullSink;
+    assert(enumerateAllPathsParallel([&](int) -> NullPathSink& { return nullSink; }, grid.data(), rows, cols, 2, true) == 0);
+}
+
+// This case will cover a 5*6 matrix with 3 snakes, every path ranked and unranked, walked from every rank
+// and enumerated in shards
+void testPathRanks() {
+    constexpr int rows = 5;
+    constexpr int cols = 6;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    for(int pos : { 8, 15, 22 }) {
+        grid[pos] = SNAKE;
+    }
+    std::stringstream serial;
+    BinaryPathSink serialSink(rows, cols, serial);
+    const int result = enumerateAllPaths(serialSink, grid.data(), rows, cols);
+    const std::vector<std::vector<int>> expected = readBinaryPaths(serial);
+
+    PathRanker ranker(grid.data(), rows, cols);
+    assert(ranker.numPaths() == uint64_t(result));
+    std::vector<PathCell> path(ranker.length());
+    for(int k = 0; k < result; k++) {
+        ranker.unrank(k, path.data());
+        for(int i = 0; i < ranker.length(); i++) {
+            assert(path[i].pos == expected[k][i]);
+        }
+        assert(ranker.rank(path.data()) == uint64_t(k));
+        PathCursor cursor(ranker, k);
+        for(int n = k; n < result; n++, cursor.next()) {
+            assert(cursor.valid() && (cursor.rank() == uint64_t(n)));
+        }
+        assert(!cursor.valid());
+    }
+
+    std::vector<std::vector<int>> shards;
+    for(uint64_t first = 0; first < ranker.numPaths(); first += 7) {
+        std::stringstream shard;
+        BinaryPathSink shardSink(rows, cols, shard);
+        assert(enumeratePathRange(shardSink, ranker, first, first + 7) == std::min<uint64_t>(7, result - first));
+        for(const std::vector<int>& p : readBinaryPaths(shard)) {
+            shards.push_back(p);
+        }
+    }
+    assert(shards == expected);
+
+    grid[rows * cols - 2] = SNAKE;
+    grid[rows * cols - 1 - cols] = SNAKE;
+    PathRanker none(grid.data(), rows, cols);
+    assert(none.numPaths() == 0);
+    assert(!PathCursor(none, 0).valid());
+}
+
+// Receives the paths of a search, and at the path interruptAt waits for the checkpoint writer and reads
+// the latest checkpoint as a kill at that point would leave it
+struct InterruptedSink {
+    TextPathSink& text;
+    CheckpointWriter& writer;
+    const char* file;
+    long long interruptAt;
+    SearchState& state;
+    long long numPaths;
+
+    template<typename PathCell>
+    void path(const PathCell* cells, int length) {
+        text.path(cells, length);
+        if((++numPaths) == interruptAt) {
+            writer.flush();
+            assert(readSearchState(file, state));
+        }
+    }
+
+    void finish() { text.finish(); }
+
+    long long sync() { return text.sync(); }
+};
+
+// This case will cover a 7*7 matrix with 2 snakes checkpointed every 20 expansions and interrupted at the
+// 100th path, the run resumed from the checkpoint must print the rest of the text of the whole run
+void testCheckpoint() {
+    constexpr int rows = 7;
+    constexpr int cols = 7;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    grid[9] = SNAKE;
+    grid[33] = SNAKE;
+    char file[] = "/tmp/checkpoint_XXXXXX";
+    int fd = mkstemp(file);
+    assert(fd >= 0);
+    close(fd);
+
+    std::ostringstream whole;
+    TextPathSink wholeSink(__FUNCTION__, whole);
+    SearchState killed{};
+    int result = 0;
+    {
+        CheckpointWriter writer(file, 20);
+        InterruptedSink sink{ wholeSink, writer, file, 100, killed, 0 };
+        result = enumerateAllPaths(sink, grid.data(), rows, cols, nullptr, &writer);
+        writer.flush();
+        assert(writer.written() > 1);
+    }
+    assert(result > 100);
+    assert((killed.numPaths > 0) && (killed.numPaths <= 100) && !killed.pos.empty());
+
+    std::ostringstream resumed;
+    TextPathSink resumedSink(__FUNCTION__, resumed, killed.numPaths);
+    assert(enumerateAllPaths(resumedSink, grid.data(), rows, cols, nullptr, nullptr, &killed) == result);
+    const std::string text = whole.str();
+    size_t cut = text.find('\n'); // the name of the grid
+    for(long long n = 0; n < killed.numPaths; n++) {
+        cut = text.find('\n', cut + 1);
+    }
+    assert(text.substr(cut + 1) == resumed.str());
+
+    SearchState last;
+    assert(readSearchState(file, last));
+    assert(last.pos.empty() && (last.numPaths == result));
+    NullPathSink nullSink;
+    assert(enumerateAllPaths(nullSink, grid.data(), rows, cols, nullptr, nullptr, &last) == result);
+    assert(nullSink.numPaths == 0);
+    unlink(file);
+}
+
+// Receives the paths of a search, makes sure a checkpoint is on disk at the path flushAt, and ends the process
+// at the path killAt as a kill would, the buffer of the sink and the state being offered left as they are
+struct KilledSink {
+    TextPathSink& text;
+    CheckpointWriter& writer;
+    long long flushAt;
+    long long killAt;
+    long long numPaths;
+
+    template<typename PathCell>
+    void path(const PathCell* cells, int length) {
+        text.path(cells, length);
+        if((++numPaths) == flushAt) writer.flush();
+        if(numPaths == killAt) _exit(0);
+    }
+
+    void finish() { text.finish(); }
+
+    long long sync() { return text.sync(); }
+};
+
+// This case will cover the run of testCheckpoint killed for real in a child process with paths still in the
+// buffer of its sink, the output cut back to the checkpoint and resumed must be the text of the whole run
+void testCheckpointKill() {
+    constexpr int rows = 7;
+    constexpr int cols = 7;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    grid[9] = SNAKE;
+    grid[33] = SNAKE;
+    std::ostringstream whole;
+    {
+        TextPathSink wholeSink(__FUNCTION__, whole);
+        enumerateAllPaths(wholeSink, grid.data(), rows, cols);
+    }
+    char file[] = "/tmp/checkpoint_XXXXXX";
+    char output[] = "/tmp/checkpoint_output_XXXXXX";
+    for(char* name : { file, output }) {
+        int fd = mkstemp(name);
+        assert(fd >= 0);
+        close(fd);
+    }
+
+    const pid_t child = fork();
+    assert(child >= 0);
+    if(child == 0) {
+        std::ofstream out(output, std::ios::binary);
+        TextPathSink text(__FUNCTION__, out);
+        CheckpointWriter writer(file, 20);
+        KilledSink sink{ text, writer, 60, 100, 0 };
+        enumerateAllPaths(sink, grid.data(), rows, cols, nullptr, &writer);
+        _exit(1); // the search ended before the kill
+    }
+    int status = 0;
+    assert((waitpid(child, &status, 0) == child) && WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    SearchState killed{};
+    assert(readSearchState(file, killed));
+    assert((killed.numPaths > 0) && (killed.numPaths <= 100) && (killed.outputBytes > 0));
+    assert(truncateOutput(output, killed));
+    {
+        std::ofstream out(output, std::ios::binary | std::ios::app);
+        TextPathSink resumedSink(__FUNCTION__, out, killed.numPaths, killed.outputBytes);
+        enumerateAllPaths(resumedSink, grid.data(), rows, cols, nullptr, nullptr, &killed);
+    }
+    std::ifstream in(output, std::ios::binary);
+    std::stringstream resumed;
+    resumed << in.rdbuf();
+    assert(resumed.str() == whole.str());
+    unlink(file);
+    unlink(output);
+}
+
+// This case will cover a 4*4 matrix with 2 snakes searched with counters, every cell pushed must be popped
+// once, and the dead ends of the plain search must be gone from the enumeration
+void testSearchStats() {
+    constexpr int rows = 4;
+    constexpr int cols = 4;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    grid[5] = SNAKE;
+    grid[14] = SNAKE;
+    NullPathSink nullSink;
+    long long expansions = 0;
+    CountingSearchStats searched;
+    const int result = searchAllPaths(nullSink, grid.data(), rows, cols, &expansions, nullptr, nullptr, &searched);
+    assert(result == 4);
+    assert(searched.nodes == expansions);
+    assert(searched.maxDepth == rows + cols - 2);
+    assert(searched.backtracks[BACKTRACK_DESTINATION] == result);
+    assert(searched.backtracks[BACKTRACK_BLOCKED] == 2); // (3, 1), reached twice, only leads into the snake at 14
+    assert(searched.backtracks[BACKTRACK_VISITED] == 0);
+    long long popped = 0;
+    for(long long n : searched.branching) {
+        popped += n;
+    }
+    assert(popped == searched.nodes);
+
+    CountingSearchStats enumerated;
+    assert(enumerateAllPaths(nullSink, grid.data(), rows, cols, &expansions, nullptr, nullptr, &enumerated) == result);
+    assert((enumerated.nodes == expansions) && (enumerated.nodes < searched.nodes));
+    assert(enumerated.backtracks[BACKTRACK_BLOCKED] == 0);
+
+    std::vector<NullPathSink> sinks(2);
+    CountingSearchStats parallel;
+    assert(enumerateAllPathsParallel([&](int t) -> NullPathSink& { return sinks[t]; }, grid.data(), rows, cols, 2,
+                                     false, 3, &parallel) == result);
+    assert(parallel.backtracks[BACKTRACK_DESTINATION] == result);
+
+    std::ostringstream json;
+    searched.writeJson(json);
+    assert(json.str().find("\"destination\": 4") != std::string::npos);
+}
+
+#ifdef BENCHMARK
+#include<fstream>       // for std::ofstream
+#include "Benchmark.h" // for secondsOf, doNotOptimize, randomGrid, mazeGrid, BenchmarkReport
+
+// the former output of printAllPaths, one flush per path
+struct EndlPathSink {
+    std::ostream& out;
+
+    template<typename PathCell>
+    void path(const PathCell* cells, int length) {
+        for(int i = 0; i + 1 < length; i++) {
+            out << cells[i].pos << " -> ";
+        }
+        out << cells[length - 1].pos << std::endl;
+    }
+
+    void finish() {}
+
+    long long sync() { return 0; } // never checkpointed
+};
+
+// Synopsis
+//     print the paths per second of the enumeration of a 13*13 open grid with every sink written to /dev/null
+void benchmarkPathSinks() {
+    constexpr int rows = 13;
+    constexpr int cols = 13;
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    std::ofstream devNull("/dev/null", std::ios::binary);
+    int numPaths = 0;
+
+    auto report = [&](const char* name, double seconds) {
+        std::cout << name << ": " << numPaths / seconds / 1e6 << " Mpaths/s" << std::endl;
+    };
+    EndlPathSink endlSink{ devNull };
+    report("endl per path", secondsOf([&] { numPaths = enumerateAllPaths(endlSink, grid.data(), rows, cols); }));
+    TextPathSink textSink("benchmark", devNull);
+    report("buffered text", secondsOf([&] { numPaths = enumerateAllPaths(textSink, grid.data(), rows, cols); }));
+    BinaryPathSink binarySink(rows, cols, devNull);
+    report("binary", secondsOf([&] { numPaths = enumerateAllPaths(binarySink, grid.data(), rows, cols); }));
+    NullPathSink nullSink;
+    report("null", secondsOf([&] { numPaths = enumerateAllPaths(nullSink, grid.data(), rows, cols); }));
+}
+
+// Synopsis
+//     print the seconds and the expansions of the search with and without dead-end pruning on snake-dense grids
+void benchmarkDeadEndPruning() {
+    constexpr int rows = 16;
+    constexpr int cols = 16;
+    // random snakes only, then a wall down column cols - 4 from row 4 leaving the lower left region a dead end
+    for(bool walled : { false, true }) {
+        for(double density : { 0.1, 0.2 }) {
+            std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, cols, density, 12);
+            if(walled) {
+                for(int i = 4; i < rows; i++) grid[i * cols + cols - 4] = SNAKE;
+            }
+            NullPathSink sink;
+            long long pruned = 0;
+            long long unpruned = 0;
+            int numPaths = 0;
+            double prunedSeconds = secondsOf([&] { numPaths = enumerateAllPaths(sink, grid.data(), rows, cols, &pruned); });
+            double unprunedSeconds = secondsOf([&] { searchAllPaths(sink, grid.data(), rows, cols, &unpruned); });
+            std::cout << (walled ? "walled, " : "") << "snake density " << density << ", " << numPaths << " paths: pruned "
+                      << pruned << " expansions " << prunedSeconds << " s, unpruned " << unpruned << " expansions "
+                      << unprunedSeconds << " s" << std::endl;
+        }
+    }
+}
+
+// Synopsis
+//     print the nodes per second of the search on the PaddedGrid of a 14*14 open grid, and the seconds of the moves
+//     of every cell of a 2048*2048 grid found with the bounds and modulo checks of a row major grid against
+//     the fixed offsets of the PaddedGrid
+void benchmarkPaddedGrid() {
+    constexpr int rows = 14;
+    constexpr int cols = 14;
+    const std::vector<CELLFLAG> open(rows * cols, FLATLAND);
+    PaddedGrid padded(open.data(), rows, cols);
+    NullPathSink sink;
+    long long expansions = 0;
+    double seconds = secondsOf([&] { searchAllPaths(sink, padded, &expansions); });
+    std::cout << "padded search " << rows << "x" << cols << ": " << expansions / seconds / 1e6 << " Mnodes/s" << std::endl;
+
+    constexpr int size = 2048;
+    const std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(size, size, 0.1, 19);
+    const int dstCell = size * size - 1;
+    long long sum = 0;
+    seconds = secondsOf([&] {
+        for(int pos = 0; pos <= dstCell; pos++) {
+            const int rightwards = pos + STEP;
+            const int downwards = pos + size;
+            sum += (((rightwards % size) != 0) && (rightwards <= dstCell) && (grid[rightwards] != SNAKE))
+                 | (((downwards <= dstCell) && (grid[downwards] != SNAKE)) << 1);
+        }
+    });
+    doNotOptimize(sum);
+    std::cout << "moves with bounds checks: " << seconds << " s" << std::endl;
+    padded = PaddedGrid(grid.data(), size, size);
+    sum = 0;
+    seconds = secondsOf([&] {
+        for(int i = 0; i < size; i++) {
+            for(int cell = padded.cell(i, 0); cell < padded.cell(i, size); cell++) {
+                sum += (padded[cell + STEP] != SNAKE) | ((padded[cell + padded.stride()] != SNAKE) << 1);
+            }
+        }
+    });
+    doNotOptimize(sum);
+    std::cout << "moves on the padded grid: " << seconds << " s" << std::endl;
+}
+
+// Synopsis
+//     print the paths per second of the parallel enumeration of a 16*16 open grid for 1, 2, 4, ... hardware threads,
+//     unordered into one NullPathSink per worker
+void benchmarkParallelEnumeration() {
+    constexpr int rows = 16;
+    constexpr int cols = 16;
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    NullPathSink serialSink;
+    long long numPaths = 0;
+    double seconds = secondsOf([&] { numPaths = enumerateAllPaths(serialSink, grid.data(), rows, cols); });
+    std::cout << "serial: " << numPaths / seconds / 1e6 << " Mpaths/s" << std::endl;
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<NullPathSink> sinks(threads);
+        seconds = secondsOf([&] {
+            numPaths = enumerateAllPathsParallel([&](int t) -> NullPathSink& { return sinks[t]; }, grid.data(), rows, cols, threads);
+        });
+        std::cout << "parallel threads " << threads << ": " << numPaths / seconds / 1e6 << " Mpaths/s" << std::endl;
+    }
+}
+
+// Synopsis
+//     print the time of unranking random paths of a 16*16 open grid and the paths per second of a shard in its middle
+void benchmarkPathRanks() {
+    constexpr int rows = 16;
+    constexpr int cols = 16;
+    constexpr int numRanks = 1000000;
+    constexpr uint64_t shardSize = 10000000;
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    PathRanker ranker(grid.data(), rows, cols);
+    std::mt19937_64 rng(5);
+    std::vector<PathCell> path(ranker.length());
+    double seconds = secondsOf([&] {
+        for(int n = 0; n < numRanks; n++) {
+            ranker.unrank(rng() % ranker.numPaths(), path.data());
+            doNotOptimize(path[rows].pos);
+        }
+    });
+    std::cout << "unrank of " << ranker.numPaths() << " paths: " << seconds / numRanks * 1e9 << " ns" << std::endl;
+    NullPathSink sink;
+    seconds = secondsOf([&] { enumeratePathRange(sink, ranker, ranker.numPaths() / 2, ranker.numPaths() / 2 + shardSize); });
+    std::cout << "shard of " << shardSize << " paths: " << shardSize / seconds / 1e6 << " Mpaths/s" << std::endl;
+}
+
+// Synopsis
+//     print the nodes per second of the search of a 14*14 open grid without and with the counters,
+//     and the counters of the latter
+void benchmarkSearchStats() {
+    constexpr int rows = 14;
+    constexpr int cols = 14;
+    const PaddedGrid open(rows, cols, FLATLAND);
+    NullPathSink sink;
+    long long expansions = 0;
+    NoSearchStats none;
+    double seconds = secondsOf([&] { searchAllPaths(sink, open, &expansions, nullptr, nullptr, &none); });
+    std::cout << "search without counters: " << expansions / seconds / 1e6 << " Mnodes/s" << std::endl;
+    CountingSearchStats counted;
+    seconds = secondsOf([&] { searchAllPaths(sink, open, &expansions, nullptr, nullptr, &counted); });
+    std::cout << "search with counters: " << expansions / seconds / 1e6 << " Mnodes/s, ";
+    counted.writeJson(std::cout);
+    std::cout << std::endl;
+}
+
+// Synopsis
+//     the suite of Answer-D, see Benchmark.h: the enumeration into a NullPathSink on open, uniform and maze grids of
+//     growing size, and the parallel enumeration of the largest open grid for 1, 2, 4, ... hardware threads
+void benchmarkSuite() {
+    BenchmarkReport report("Answer-D");
+    constexpr uint64_t seed = 20;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    NullPathSink sink;
+    for(int size : { 9, 11, 13 }) {
+        const std::vector<CELLFLAG> open(size * size, FLATLAND);
+        const std::vector<CELLFLAG> uniform = randomGrid<CELLFLAG>(size + 4, size + 4, 0.1, seed);
+        const std::vector<CELLFLAG> maze = mazeGrid<CELLFLAG>(2 * size + 1, 2 * size + 1, 0.5, seed);
+        report.measure({ "enumerateAllPaths", "open", 0, size, size, 0, 1, true },
+                       [&] { return enumerateAllPaths(sink, open.data(), size, size); });
+        report.measure({ "enumerateAllPaths", "uniform", seed, size + 4, size + 4, 0.1, 1, true },
+                       [&] { return enumerateAllPaths(sink, uniform.data(), size + 4, size + 4); });
+        report.measure({ "enumerateAllPaths", "maze", seed, 2 * size + 1, 2 * size + 1, 0.5, 1, true },
+                       [&] { return enumerateAllPaths(sink, maze.data(), 2 * size + 1, 2 * size + 1); });
+    }
+    constexpr int size = 13;
+    const std::vector<CELLFLAG> open(size * size, FLATLAND);
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<NullPathSink> sinks(threads);
+        report.measure({ "enumerateAllPathsParallel", "open", 0, size, size, 0, threads, true }, [&] {
+            return enumerateAllPathsParallel([&](int t) -> NullPathSink& { return sinks[t]; }, open.data(), size, size, threads);
+        });
+    }
+}
+#endif
+
 int main() {
+#ifdef BENCHMARK
+    benchmarkPathSinks();
+    benchmarkDeadEndPruning();
+    benchmarkPaddedGrid();
+    benchmarkParallelEnumeration();
+    benchmarkPathRanks();
+    benchmarkSearchStats();
+    benchmarkSuite();
+    return 0;
+#endif
     testZeroPath1(); // 0 path expected
     testZeroPath2(); // 0 path expected
     testZeroPath3(); // 0 path expected
@@ -204,4 +1271,12 @@ int main() {
     testFullPath();  // 6 paths expected
     testNumPathOfRectMatrix1(); // 1 path expected
     testNumPathOfRectMatrix2(); // 1 path expected
+    testPackedGrid();           // 2 paths expected
+    testPathSinks();            // 3 paths expected by every sink
+    testDeadEndPruning();       // the same paths expected with fewer expansions
+    testParallelEnumeration();  // the serial paths expected from every split
+    testPathRanks();            // the serial paths expected from every rank
+    testCheckpoint();           // the rest of the paths expected from the checkpoint
+    testCheckpointKill();       // the text of the whole run expected from the killed run and its resume
+    testSearchStats();          // every cell pushed expected to be popped once
 }
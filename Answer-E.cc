@@ -7,11 +7,19 @@
 
 #include<cassert>
 #include<iostream>
+#include<atomic>   // for std::atomic
+#include<cstdint>  // for uint8_t, uint64_t
+#include<sstream>  // for std::ostringstream
+#include<thread>   // for std::thread
+#include<utility>  // for std::swap
+#include<vector>   // for std::vector
 
-enum CELLFLAG {
-    SNAKE,
-    FLATLAND
-};
+#include "Checkpoint.h"  // for CheckpointWriter, SearchState
+#include "Grid.h"        // for CELLFLAG, PaddedGrid
+#include "PackedGrid.h"  // for PackedGridView, PackedGrid
+#include "PathCounter.h" // for the counter policies
+#include "PathSink.h"    // for TextPathSink, NullPathSink
+#include "SearchStats.h" // for SearchStats, CountingSearchStats
 
 enum VISITEDFLAG {
     UNVISITED,
@@ -19,71 +27,45 @@ enum VISITEDFLAG {
 };
 
 struct Cell {
-    int  pos;
+    int  pos;  // the cell index by row major order
+    int  cell; // the index of the same cell in the PaddedGrid
 	// bit 0 for rightwards, bit 1 for downwards, bit 2 for leftwards, bit 3 for upwards; 1 represents forward available and 0 for blocked
     char adj;
 };
 
 // Input
-//     grid      : the pointer which points to the matrix by row major order
+//     grid      : the padded matrix, see Grid.h
 //     paths     : the pointer which points to the array which store the nodes in the path
 //     cellIndex : the cell to be reset
-//     rows      : the number of matrix rows
-//     columns   : the number of matrix columns
 // Output
 //     available towards of paths[cellIndex].adj
 // Synopsis
-//     reset the avaliable towards(rightwards & downwards & leftwards & upwards) of the cell which is in cellIndex
-inline void resetCellAdj(CELLFLAG* grid, Cell* paths, int cellIndex, int rows, int columns) {
-    const int dstCell = rows * columns - 1;
-    paths[cellIndex].adj = 0;
-	const int curPos = paths[cellIndex].pos;
-    int rightwards = curPos + 1;
-    int downwards = curPos + columns;
-	int leftwards = curPos - 1;
-    int upwards = curPos - columns;
-	
-    if(((rightwards % columns) != 0) && (rightwards <= dstCell) && (grid[rightwards] != SNAKE)) { // rightwards available
-        paths[cellIndex].adj |= 0x01;
-    }
-    
-    if((downwards <= dstCell) && (grid[downwards] != SNAKE)) { // downwards available
-        paths[cellIndex].adj |= 0x02;
-    }
-	
-	if(((curPos % columns) != 0) && (leftwards >= 0) && (grid[leftwards] != SNAKE)) { // leftwards available
-		paths[cellIndex].adj |= 0x04;
-	}
-	
-	if((upwards >= 0) && (grid[upwards] != SNAKE)) { // upwards available
-		paths[cellIndex].adj |= 0x08;
-	}
+//     reset the avaliable towards(rightwards & downwards & leftwards & upwards) of the cell which is in cellIndex,
+//     the SNAKE border stands for the edges of the matrix
+inline void resetCellAdj(const PaddedGrid& grid, Cell* paths, int cellIndex) {
+    const int cell = paths[cellIndex].cell;
+    const int down = grid.stride();
+    paths[cellIndex].adj = char((grid[cell + 1] != SNAKE) | ((grid[cell + down] != SNAKE) << 1)
+                              | ((grid[cell - 1] != SNAKE) << 2) | ((grid[cell - down] != SNAKE) << 3));
 }
 
 // Input
 //     gridName  : the name of grid
-//     grid      : the pointer which points to the matrix by row major order
-//     rows      : the number of matrix rows
-//     columns   : the number of matrix columns
+//     grid      : the padded matrix, see Grid.h
 // Output
 //     number of correct paths
 // Synopsis
 //     print all paths from top-left-most cell to the bottom-right-most cell which move up/down/left/right, but cannot revisit a cell it has already visited, and do so one cell at a time
-int printAllPaths(const char* gridName, CELLFLAG* grid, int rows, int columns) {
+int printAllPaths(const char* gridName, const PaddedGrid& grid) {
     constexpr int EMPTYSTACK = -1;
+    const int columns = grid.columns();
+    const int down = grid.stride();
+    const int dstCell = grid.destination();
     int numPaths = 0;
-    const int dstCell = rows * columns - 1;
-    VISITEDFLAG vis[rows * columns];
-    for(int i = 0; i < (rows * columns); i++) {
-        vis[i] = UNVISITED;
-    }
+    std::vector<VISITEDFLAG> vis(grid.size(), UNVISITED);
 
     // treat paths as stack
-    Cell paths[rows * columns];
-    for(int i = 0; i < (rows * columns); i++) {
-        paths[i].pos = 0;
-        paths[i].adj = 0;
-    }
+    std::vector<Cell> paths(size_t(grid.rows()) * columns);
     int curStep = EMPTYSTACK;
     
     // move to next position in stack
@@ -91,65 +73,53 @@ int printAllPaths(const char* gridName, CELLFLAG* grid, int rows, int columns) {
     
     // push source cell into stack at curStep
     paths[curStep].pos = 0;
-    resetCellAdj(grid, paths, 0, rows, columns);
+    paths[curStep].cell = grid.source();
+    resetCellAdj(grid, paths.data(), 0);
+
+    // push the cell at offset move of the top of the stack, pos moving by step
+    auto push = [&](int move, int step) {
+        vis[paths[curStep].cell] = VISITED;
+        curStep++;
+        paths[curStep].pos = paths[curStep - 1].pos + step;
+        paths[curStep].cell = paths[curStep - 1].cell + move;
+        resetCellAdj(grid, paths.data(), curStep);
+    };
 
     while(curStep >= 0) { // until stack empty
-		const int curPos     = paths[curStep].pos;
-        const int rightwards = curPos + 1;
-        const int downwards  = curPos + columns;
-        const int leftwards  = curPos - 1;
-        const int upwards    = curPos - columns;
-        if((curPos == dstCell)) { // print path
+        Cell& cur = paths[curStep];
+        if(cur.cell == dstCell) { // print path
             if((++numPaths) == 1) {
                 std::cout << "paths of function " << gridName << ": " << std::endl;
             }
             for(int i = 0; i < curStep; i++) {
                 std::cout << paths[i].pos << " -> ";
             }
-            std::cout << paths[curStep].pos << std::endl;
-            vis[curPos] = UNVISITED;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+            std::cout << cur.pos << std::endl;
+            vis[cur.cell] = UNVISITED;
             curStep--; // pop from stack
         }
 		// move rightwards
-        else if(((rightwards % columns) != 0) && (rightwards <= dstCell) && (grid[rightwards] != SNAKE) && (vis[rightwards] == UNVISITED) && ((paths[curStep].adj & 0x01) == 1)) {
-            paths[curStep].adj &= 0xFE;
-            vis[curPos] = VISITED;
-            // push rightwards cell into stack at curStep
-            curStep++;
-            paths[curStep].pos = rightwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+        else if(((cur.adj & 0x01) != 0) && (vis[cur.cell + 1] == UNVISITED)) {
+            cur.adj &= 0xFE;
+            push(1, 1);
         }
 		// move downwards
-        else if((downwards <= dstCell) && (grid[downwards] != SNAKE) && (vis[downwards] == UNVISITED) && ((paths[curStep].adj & 0x02) != 0)) {
-            paths[curStep].adj &= 0xFD;
-            vis[curPos] = VISITED;
-            // push downwards cell into stack at curStep
-            curStep++;
-            paths[curStep].pos = downwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+        else if(((cur.adj & 0x02) != 0) && (vis[cur.cell + down] == UNVISITED)) {
+            cur.adj &= 0xFD;
+            push(down, columns);
         }
 		// move leftwards
-        else if(((curPos % columns) != 0) && (leftwards <= dstCell) && (grid[leftwards] != SNAKE) && (vis[leftwards] == UNVISITED) && ((paths[curStep].adj & 0x04) != 0)) {
-            paths[curStep].adj &= 0xFB;
-            vis[curPos] = VISITED;
-            // push leftwards cell into stack at curStep
-            curStep++;
-            paths[curStep].pos = leftwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+        else if(((cur.adj & 0x04) != 0) && (vis[cur.cell - 1] == UNVISITED)) {
+            cur.adj &= 0xFB;
+            push(-1, -1);
         }
 		// move upwards
-        else if((upwards <= dstCell) && (grid[upwards] != SNAKE) && (vis[upwards] == UNVISITED) && ((paths[curStep].adj & 0x08) != 0)) {
-            paths[curStep].adj &= 0xF7;
-            vis[curPos] = VISITED;
-            // push upwards cell into stack at curStep
-            curStep++;
-            paths[curStep].pos = upwards;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+        else if(((cur.adj & 0x08) != 0) && (vis[cur.cell - down] == UNVISITED)) {
+            cur.adj &= 0xF7;
+            push(-down, -columns);
         }
         else { // blocked, backtrack
-            vis[curPos] = UNVISITED;
-            resetCellAdj(grid, paths, curStep, rows, columns);
+            vis[cur.cell] = UNVISITED;
             curStep--; // pop from stack
         }
     }
@@ -157,6 +127,604 @@ int printAllPaths(const char* gridName, CELLFLAG* grid, int rows, int columns) {
     return numPaths;
 }
 
+// Input
+//     gridName  : the name of grid
+//     grid      : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows      : the number of matrix rows
+//     columns   : the number of matrix columns
+// Output
+//     number of correct paths
+// Synopsis
+//     the search above on the PaddedGrid of the matrix
+template<typename Grid>
+int printAllPaths(const char* gridName, Grid grid, int rows, int columns) {
+    return printAllPaths(gridName, PaddedGrid(grid, rows, columns));
+}
+
+// Input
+//     gridName  : the name of grid
+//     grid      : the bit-packed matrix, e.g. the view of a MappedGrid
+// Output
+//     number of correct paths
+// Synopsis
+//     the same search as above; the bits are expanded into the PaddedGrid the search runs on, one CELLFLAG per
+//     cell, which is the same order of memory as the visited flags and the stack of the search itself,
+//     so a mapped grid is not searched in place
+int printAllPaths(const char* gridName, const PackedGridView& grid) {
+    return printAllPaths(gridName, grid, grid.rows, grid.columns);
+}
+
+// a board row holds the columns and a zero sentinel on each side
+constexpr int MAX_BITBOARD_COLUMNS = 62;
+
+struct BitboardCell {
+    int      pos;
+    int      row;
+    unsigned adj; // bit 0 for rightwards, bit 1 for downwards, bit 2 for leftwards, bit 3 for upwards; the moves not tried yet
+};
+
+// Input
+//     board       : the bitboard, free or reach of searchAllPaths
+//     row, column : the cell
+// Output
+//     bit 0 for rightwards, bit 1 for downwards, bit 2 for leftwards, bit 3 for upwards; set if the cell there is on board
+inline unsigned bitboardMoves(const uint64_t* board, int row, int column) {
+    const unsigned around = unsigned(board[row] >> column);
+    return ((around >> 2) & 1) | ((unsigned(board[row + 1] >> (column + 1)) & 1) << 1)
+         | ((around & 1) << 2) | ((unsigned(board[row - 1] >> (column + 1)) & 1) << 3);
+}
+
+// Input
+//     free        : the bitboard of the cells not on the path
+//     row, column : the cell just put on the path
+// Output
+//     false if the free cells next to the cell are still connected around it, so the move cannot cut the free region
+// Synopsis
+//     the 8 cells around, clockwise from the top one, are looked up in a table which tells if the free runs
+//     of the ring holding a top, right, bottom or left cell are more than one
+inline bool mayCut(const uint64_t* free, int row, int column) {
+    static const std::vector<uint8_t> cuts = [] {
+        std::vector<uint8_t> table(256);
+        for(unsigned ring = 0; ring < 256; ring++) {
+            int runs = 0;
+            for(int k = 0; k < 8; k += 2) { // a run holding an orthogonal cell, counted at its first one
+                if(!((ring >> k) & 1)) continue;
+                bool first = true;
+                for(int m = (k + 7) % 8; (ring >> m) & 1; m = (m + 7) % 8) {
+                    if(m == k) break; // the whole ring is free
+                    if((m % 2) == 0) first = false;
+                }
+                runs += first;
+            }
+            table[ring] = (runs > 1);
+        }
+        return table;
+    }();
+    const unsigned above = unsigned(free[row - 1] >> column) & 7; // left, top, right
+    const unsigned here = unsigned(free[row] >> column) & 7;
+    const unsigned below = unsigned(free[row + 1] >> column) & 7;
+    const unsigned ring = ((above >> 1) & 1) | ((above >> 2) << 1) | ((here >> 2) << 2) | ((below >> 2) << 3)
+                        | (((below >> 1) & 1) << 4) | ((below & 1) << 5) | ((here & 1) << 6) | ((above & 1) << 7);
+    return cuts[ring] != 0;
+}
+
+// Input
+//     flatland : the bitboard of the FLATLAND cells, free before the search, from its sentinel row above row 0;
+//                empty and null when the stats are compiled out, so the offset is taken here and not by the caller
+//     free     : the bitboard of the cells not on the path
+//     cell     : the top of the stack, which pushed nothing
+//     columns  : the number of matrix columns
+//     dstCell  : the bottom-right-most cell
+// Output
+//     why the cell is popped, see SearchStats.h: its free neighbours were dropped by the cut pruning, or
+//     its FLATLAND neighbours are all on the path, or it has none
+inline BACKTRACK leafBacktrack(const uint64_t* flatland, const uint64_t* free, const BitboardCell& cell, int columns, int dstCell) {
+    if(cell.pos == dstCell) return BACKTRACK_DESTINATION;
+    const int column = cell.pos - cell.row * columns;
+    if(bitboardMoves(free, cell.row, column) != 0) return BACKTRACK_PRUNED;
+    return (bitboardMoves(flatland + 1, cell.row, column) != 0) ? BACKTRACK_VISITED : BACKTRACK_BLOCKED;
+}
+
+// Input
+//     free    : the bitboard of the cells not on the path
+//     reach   : the bitboard to be written, with the same sentinels
+//     rows    : the number of matrix rows
+//     columns : the number of matrix columns
+// Synopsis
+//     flood fill of the free cells connected to the bottom-right-most cell, a row at a time in both directions
+//     until nothing changes
+inline void floodFromDestination(const uint64_t* free, uint64_t* reach, int rows, int columns) {
+    for(int i = -1; i <= rows; i++) {
+        reach[i] = 0;
+    }
+    reach[rows - 1] = free[rows - 1] & (uint64_t(1) << columns);
+    auto spread = [&](int i) {
+        uint64_t row = (reach[i] | reach[i - 1] | reach[i + 1]) & free[i];
+        for(uint64_t wider = (row | (row << 1) | (row >> 1)) & free[i]; wider != row; wider = (row | (row << 1) | (row >> 1)) & free[i]) {
+            row = wider;
+        }
+        const bool changed = (row != reach[i]);
+        reach[i] = row;
+        return changed;
+    };
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(int i = rows - 1; i >= 0; i--) {
+            changed |= spread(i);
+        }
+        for(int i = 0; i < rows; i++) {
+            changed |= spread(i);
+        }
+    }
+}
+
+// Input
+//     PruneCuts     : true to cut the moves which cannot lead to the destination any more
+//     sink          : the PathSink which receives every path, see PathSink.h
+//     grid          : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows          : the number of matrix rows
+//     columns       : the number of matrix columns, at most MAX_BITBOARD_COLUMNS
+//     numExpansions : if not null, the number of cells pushed into the stack
+//     checkpoint    : if not null, the writer the stack is offered to, see Checkpoint.h
+//     resume        : if not null, the checkpoint of an earlier run on the same grid with the same PruneCuts to go on from
+//     stats         : if not null, the counters of the search are added to it, see SearchStats.h
+// Output
+//     number of correct paths, those before the checkpoint resumed included
+// Synopsis
+//     the depth first search of printAllPaths, the same paths in the same order, on a bitboard:
+//     free[i] has bit j + 1 set for the FLATLAND cells of row i which are not on the path, and the rows -1 and rows
+//     and the bits 0 and columns + 1 are zero sentinels, so the four moves of a cell are four shifts and ANDs
+//     with no bounds check, and a push or a pop clears or sets one bit.
+//     With PruneCuts, every cell pushed is connected to the destination by free cells. A push which may cut the
+//     free region, see mayCut, floods it from the destination and keeps only the moves into the flooded cells;
+//     any other push leaves the free neighbours of the cell connected to each other and so to the destination
+template<bool PruneCuts = true, typename Sink, typename Grid, typename Stats = SearchStats>
+long long searchAllPaths(Sink& sink, Grid grid, int rows, int columns, long long* numExpansions = nullptr,
+                         CheckpointWriter* checkpoint = nullptr, const SearchState* resume = nullptr, Stats* stats = nullptr) {
+    assert(columns <= MAX_BITBOARD_COLUMNS);
+    std::vector<uint64_t> board(size_t(rows) + 2, 0);
+    std::vector<uint64_t> flooded(size_t(rows) + 2, 0);
+    uint64_t* free = board.data() + 1;
+    uint64_t* reach = flooded.data() + 1;
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < columns; j++) {
+            free[i] |= uint64_t(grid[i * columns + j] != SNAKE) << (j + 1);
+        }
+    }
+    const std::vector<uint64_t> flatland = Stats::ENABLED ? board : std::vector<uint64_t>(); // for leafBacktrack only
+    const int delta[4] = { 1, columns, -1, -columns };
+    const int rowDelta[4] = { 0, 1, 0, -1 };
+
+    long long numPaths = 0;
+    long long expansions = 1; // the source
+    Stats local;
+    const int dstCell = rows * columns - 1;
+    std::vector<BitboardCell> paths(size_t(rows) * columns);
+    int curStep = 0;
+    paths[0] = BitboardCell{ 0, 0, bitboardMoves(free, 0, 0) };
+    free[0] &= ~uint64_t(2); // the source is on the path whatever its flag, as in printAllPaths
+    local.push(0);
+    if(PruneCuts && (dstCell != 0)) {
+        floodFromDestination(free, reach, rows, columns);
+        paths[0].adj &= bitboardMoves(reach, 0, 0);
+    }
+    if(resume != nullptr) { // the stack of the checkpoint, its cells are off the board
+        assert((resume->rows == rows) && (resume->columns == columns));
+        curStep = int(resume->pos.size()) - 1;
+        for(int k = 0; k <= curStep; k++) {
+            const int row = resume->pos[k] / columns;
+            paths[k] = BitboardCell{ resume->pos[k], row, resume->adj[k] };
+            free[row] &= ~(uint64_t(1) << (resume->pos[k] - row * columns + 1));
+            if(k > 0) local.push(k);
+        }
+        numPaths = resume->numPaths;
+        expansions = resume->expansions;
+    }
+
+    while(curStep >= 0) { // until stack empty
+        if((checkpoint != nullptr) && checkpoint->due(expansions)) { // the paths counted are out before the state
+            checkpoint->offer(paths.data(), curStep + 1, rows, columns, numPaths, expansions, sink.sync());
+        }
+        BitboardCell& cur = paths[curStep];
+        if((cur.pos != dstCell) && (cur.adj != 0)) { // push the next move
+            const int d = __builtin_ctz(cur.adj);
+            cur.adj &= cur.adj - 1;
+            const int pos = cur.pos + delta[d];
+            const int row = cur.row + rowDelta[d];
+            const int column = pos - row * columns;
+            free[row] &= ~(uint64_t(1) << (column + 1));
+            unsigned moves = bitboardMoves(free, row, column);
+            if(PruneCuts && (pos != dstCell) && mayCut(free, row, column)) {
+                floodFromDestination(free, reach, rows, columns);
+                moves &= bitboardMoves(reach, row, column);
+            }
+            paths[++curStep] = BitboardCell{ pos, row, moves };
+            expansions++;
+            local.push(curStep);
+            continue;
+        }
+        if(cur.pos == dstCell) { // emit path
+            numPaths++;
+            sink.path(paths.data(), curStep + 1);
+        }
+        local.pop(curStep, [&] { return leafBacktrack(flatland.data(), free, cur, columns, dstCell); });
+        free[cur.row] |= uint64_t(1) << (cur.pos - cur.row * columns + 1); // pop from stack
+        curStep--;
+    }
+
+    sink.finish();
+    if(checkpoint != nullptr) { // the search is over, a resume from here emits nothing
+        checkpoint->offer(paths.data(), 0, rows, columns, numPaths, expansions, sink.sync(), true);
+    }
+    if(numExpansions != nullptr) {
+        *numExpansions = expansions;
+    }
+    if(stats != nullptr) {
+        stats->merge(local);
+    }
+    return numPaths;
+}
+
+// Input
+//     PruneCuts  : as searchAllPaths
+//     sink       : the PathSink which receives every path below the prefix
+//     flatland   : the bitboard of the FLATLAND cells from its sentinel row, see leafBacktrack
+//     free       : the bitboard of searchAllPaths, the cells of the prefix cleared
+//     reach      : the bitboard flooded by PruneCuts, with the same sentinels
+//     rows       : the number of matrix rows
+//     columns    : the number of matrix columns
+//     paths      : the stack, paths[0 .. depth - 1] is the prefix and it has room for a whole path;
+//                  the moves of the last cell of the prefix are the ones to be searched
+//     depth      : the length of the prefix
+//     expansions : the number of cells pushed is added to it
+//     stats      : the counters of the search, the last cell of the prefix counted as pushed, see SearchStats.h
+// Output
+//     number of paths below the prefix
+// Synopsis
+//     the depth first search of searchAllPaths which never pops the prefix, the board is left as it was given
+template<bool PruneCuts, typename Sink, typename Stats>
+long long searchSubtree(Sink& sink, const uint64_t* flatland, uint64_t* free, uint64_t* reach, int rows, int columns,
+                        BitboardCell* paths, int depth, long long& expansions, Stats& stats) {
+    const int delta[4] = { 1, columns, -1, -columns };
+    const int rowDelta[4] = { 0, 1, 0, -1 };
+    const int dstCell = rows * columns - 1;
+    long long numPaths = 0;
+    int curStep = depth - 1;
+    stats.push(curStep);
+    while(curStep >= depth - 1) {
+        BitboardCell& cur = paths[curStep];
+        if((cur.pos != dstCell) && (cur.adj != 0)) { // push the next move
+            const int d = __builtin_ctz(cur.adj);
+            cur.adj &= cur.adj - 1;
+            const int pos = cur.pos + delta[d];
+            const int row = cur.row + rowDelta[d];
+            const int column = pos - row * columns;
+            free[row] &= ~(uint64_t(1) << (column + 1));
+            unsigned moves = bitboardMoves(free, row, column);
+            if(PruneCuts && (pos != dstCell) && mayCut(free, row, column)) {
+                floodFromDestination(free, reach, rows, columns);
+                moves &= bitboardMoves(reach, row, column);
+            }
+            paths[++curStep] = BitboardCell{ pos, row, moves };
+            expansions++;
+            stats.push(curStep);
+            continue;
+        }
+        if(cur.pos == dstCell) { // emit path
+            numPaths++;
+            sink.path(paths, curStep + 1);
+        }
+        stats.pop(curStep, [&] { return leafBacktrack(flatland, free, cur, columns, dstCell); });
+        if(curStep > depth - 1) { // pop from stack
+            free[cur.row] |= uint64_t(1) << (cur.pos - cur.row * columns + 1);
+        }
+        curStep--;
+    }
+    return numPaths;
+}
+
+// Input
+//     PruneCuts      : as searchAllPaths
+//     grid           : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows           : the number of matrix rows
+//     columns        : the number of matrix columns, at most MAX_BITBOARD_COLUMNS
+//     numThreads     : the number of worker threads
+//     tasksPerThread : the prefixes are lengthened until there are this many per thread
+//     stats          : if not null, the counters of the subtrees searched are added to it, see SearchStats.h
+// Output
+//     number of correct paths, the number searchAllPaths returns
+// Synopsis
+//     the prefixes of the search are lengthened a cell at a time, all of them together, until there are enough
+//     of them or none is left; a prefix which reaches the destination is a path counted there.
+//     The prefixes are the tasks of a lock-free queue, an atomic index into them: every worker claims the next
+//     one, lays it on its own copy of the board and stack and counts the paths below it with searchSubtree.
+//     The counts and the Stats of the workers are summed after they join
+template<bool PruneCuts = true, typename Grid, typename Stats = SearchStats>
+long long countPathsParallel(Grid grid, int rows, int columns, int numThreads, int tasksPerThread = 64,
+                             Stats* stats = nullptr) {
+    assert(columns <= MAX_BITBOARD_COLUMNS);
+    assert(numThreads > 0);
+    const int dstCell = rows * columns - 1;
+    if(dstCell == 0) return 1; // the source is the destination whatever its flag, as in printAllPaths
+    std::vector<uint64_t> initial(size_t(rows) + 2, 0);
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < columns; j++) {
+            initial[i + 1] |= uint64_t(grid[i * columns + j] != SNAKE) << (j + 1);
+        }
+    }
+    const std::vector<uint64_t> flatland = Stats::ENABLED ? initial : std::vector<uint64_t>(); // for leafBacktrack only
+    initial[1] &= ~uint64_t(2); // the source is on the path whatever its flag
+
+    // Synopsis
+    //     lay the depth cells of prefix on a copy of the initial board and on the stack, the last one with its moves
+    auto layPrefix = [&](const int* prefix, int depth, std::vector<uint64_t>& board, uint64_t* reach, BitboardCell* paths) {
+        board = initial;
+        uint64_t* free = board.data() + 1;
+        for(int k = 0; k < depth; k++) {
+            const int row = prefix[k] / columns;
+            free[row] &= ~(uint64_t(1) << (prefix[k] - row * columns + 1));
+            paths[k] = BitboardCell{ prefix[k], row, 0 };
+        }
+        BitboardCell& last = paths[depth - 1];
+        last.adj = bitboardMoves(free, last.row, last.pos - last.row * columns);
+        if(PruneCuts) { // a prefix is laid once, so its last cell is always flooded
+            floodFromDestination(free, reach, rows, columns);
+            last.adj &= bitboardMoves(reach, last.row, last.pos - last.row * columns);
+        }
+    };
+
+    const int delta[4] = { 1, columns, -1, -columns };
+    long long numPaths = 0; // the prefixes which reach the destination
+    int depth = 1;
+    std::vector<int> prefixes(1, 0); // depth cells each, back to back
+    {
+        std::vector<uint64_t> board;
+        std::vector<uint64_t> flooded(size_t(rows) + 2, 0);
+        std::vector<BitboardCell> paths(size_t(rows) * columns);
+        while(!prefixes.empty() && (prefixes.size() / depth < size_t(tasksPerThread) * numThreads)) {
+            std::vector<int> longer;
+            for(size_t first = 0; first < prefixes.size(); first += depth) {
+                const int* prefix = prefixes.data() + first;
+                layPrefix(prefix, depth, board, flooded.data() + 1, paths.data());
+                for(unsigned moves = paths[depth - 1].adj; moves != 0; moves &= moves - 1) {
+                    const int next = prefix[depth - 1] + delta[__builtin_ctz(moves)];
+                    if(next == dstCell) {
+                        numPaths++;
+                        continue;
+                    }
+                    longer.insert(longer.end(), prefix, prefix + depth);
+                    longer.push_back(next);
+                }
+            }
+            prefixes.swap(longer);
+            depth++;
+        }
+    }
+
+    const size_t numTasks = prefixes.size() / depth;
+    std::atomic<size_t> nextTask(0);
+    std::atomic<long long> total(numPaths);
+    std::vector<Stats> locals(numThreads);
+    auto worker = [&](int self) {
+        std::vector<uint64_t> board;
+        std::vector<uint64_t> flooded(size_t(rows) + 2, 0);
+        std::vector<BitboardCell> paths(size_t(rows) * columns);
+        NullPathSink sink;
+        long long expansions = 0;
+        Stats counted; // on the stack of the worker, not next to the counters of another one
+        for(size_t task = nextTask++; task < numTasks; task = nextTask++) {
+            layPrefix(prefixes.data() + task * depth, depth, board, flooded.data() + 1, paths.data());
+            searchSubtree<PruneCuts>(sink, flatland.data(), board.data() + 1, flooded.data() + 1, rows, columns,
+                                     paths.data(), depth, expansions, counted);
+        }
+        total += sink.numPaths;
+        locals[self] = counted;
+    };
+    std::vector<std::thread> workers;
+    for(int t = 1; t < numThreads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for(std::thread& t : workers) {
+        t.join();
+    }
+    if(stats != nullptr) {
+        for(const Stats& local : locals) {
+            stats->merge(local);
+        }
+    }
+    return total;
+}
+
+// The plugs of the frontier of countAllPaths, 2 bits each:
+//     NOPLUG     : no path crosses the edge
+//     OPENPLUG   : the left end of a path segment whose both ends cross the frontier
+//     CLOSEPLUG  : the right end of such a segment, the segments nest like parentheses
+//     SOURCEPLUG : the end of the segment which starts at the top-left-most cell
+enum PLUG {
+    NOPLUG,
+    OPENPLUG,
+    CLOSEPLUG,
+    SOURCEPLUG
+};
+
+constexpr int PLUG_BITS = 2;
+constexpr int MAX_PLUG_COLUMNS = 64 / PLUG_BITS - 1;
+
+inline int plugAt(uint64_t state, int k) {
+    return int((state >> (PLUG_BITS * k)) & 3);
+}
+
+inline uint64_t setPlug(uint64_t state, int k, int plug) {
+    return (state & ~(uint64_t(3) << (PLUG_BITS * k))) | (uint64_t(plug) << (PLUG_BITS * k));
+}
+
+// Input
+//     state : the plugs of the frontier
+//     k     : an OPENPLUG or a CLOSEPLUG
+// Output
+//     the other end of its segment, found by matching the parentheses
+inline int matchingPlug(uint64_t state, int k) {
+    const int open = plugAt(state, k);
+    const int step = (open == OPENPLUG) ? 1 : -1;
+    int depth = 0;
+    for(int m = k;; m += step) {
+        const int plug = plugAt(state, m);
+        if(plug == open) depth++;
+        else if(plug == (OPENPLUG ^ CLOSEPLUG ^ open)) depth--;
+        if(depth == 0) return m;
+    }
+}
+
+// Open addressing hash map from the frontier states to their numbers of partial paths.
+// The states and counts are kept dense in insertion order so that a pass over the table is sequential,
+// the slots only hold their indices.
+template<typename Counter>
+class PlugStateTable {
+public:
+    PlugStateTable() : slots(1024, -1), mask(1023) {}
+
+    size_t size() const { return states.size(); }
+    uint64_t state(size_t k) const { return states[k]; }
+    const Counter& count(size_t k) const { return counts[k]; }
+
+    void clear() {
+        states.clear();
+        counts.clear();
+        std::fill(slots.begin(), slots.end(), -1);
+    }
+
+    // Synopsis
+    //     count is added to the partial paths of state
+    void add(uint64_t state, const Counter& count) {
+        for(size_t slot = hash(state);; slot = (slot + 1) & mask) {
+            if(slots[slot] < 0) {
+                slots[slot] = int32_t(states.size());
+                states.push_back(state);
+                counts.push_back(count);
+                if(states.size() * 2 > slots.size()) grow();
+                return;
+            }
+            if(states[slots[slot]] == state) {
+                counts[slots[slot]] += count;
+                return;
+            }
+        }
+    }
+
+private:
+    size_t hash(uint64_t state) const {
+        return size_t((state * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    void grow() {
+        slots.assign(slots.size() * 2, -1);
+        mask = slots.size() - 1;
+        for(size_t k = 0; k < states.size(); k++) {
+            size_t slot = hash(states[k]);
+            while(slots[slot] >= 0) slot = (slot + 1) & mask;
+            slots[slot] = int32_t(k);
+        }
+    }
+
+    std::vector<uint64_t> states;
+    std::vector<Counter> counts;
+    std::vector<int32_t> slots;
+    size_t mask;
+};
+
+// Input
+//     grid    : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix
+//     rows    : the number of matrix rows
+//     columns : the number of matrix columns
+// Output
+//     the number of paths printAllPaths would print, as Counter: uint64_t by default, or uint128_t, ModCounter and
+//     BigCounter from PathCounter.h
+// Synopsis
+//     plug dynamic programming over the cells by row major order. The frontier between the cells done and the cells
+//     to do is crossed by width + 1 edges: plug j is the left edge of the current cell, plug j + 1 its top edge, and
+//     the others the bottom edges of the cells above the frontier. A state is the plugs of every edge, and the
+//     number of its partial paths is kept in a PlugStateTable. At every cell the path goes through or not:
+//         no plug in                   : the cell stays empty, or a new segment starts rightwards and downwards
+//         one plug in                  : the segment goes on rightwards or downwards
+//         two plugs in                 : the two segments join, unless they are the two ends of one segment
+//     the source starts the SOURCEPLUG segment and the destination must end it with no other plug left.
+//     The width is the smaller side, the grid being transposed if it is wider than tall, and at most MAX_PLUG_COLUMNS;
+//     the number of states grows exponentially with the width and linearly with the height
+template<typename Counter = uint64_t, typename Grid>
+Counter countAllPaths(Grid grid, int rows, int columns) {
+    const bool transposed = columns > rows;
+    const int height = transposed ? columns : rows;
+    const int width = transposed ? rows : columns;
+    assert(width <= MAX_PLUG_COLUMNS);
+    std::vector<uint8_t> flat(size_t(rows) * columns);
+    for(int i = 0; i < height; i++) {
+        for(int j = 0; j < width; j++) {
+            flat[size_t(i) * width + j] = (grid[transposed ? j * columns + i : i * columns + j] != SNAKE);
+        }
+    }
+    const int dstCell = height * width - 1;
+    flat[0] = 1; // the rabbit is in the source whatever its flag, as in printAllPaths
+    if(!flat[dstCell]) return Counter(0);
+    if(dstCell == 0) return Counter(1);
+
+    PlugStateTable<Counter> cur, next;
+    cur.add(0, Counter(1));
+    for(int i = 0; i < height; i++) {
+        for(int j = 0; j < width; j++) {
+            const int pos = i * width + j;
+            const bool canDown = (i + 1 < height) && flat[pos + width];
+            const bool canRight = (j + 1 < width) && flat[pos + 1];
+            next.clear();
+            for(size_t k = 0; k < cur.size(); k++) {
+                const uint64_t state = cur.state(k);
+                const Counter& count = cur.count(k);
+                const int left = plugAt(state, j);
+                const int up = plugAt(state, j + 1);
+                const uint64_t empty = setPlug(setPlug(state, j, NOPLUG), j + 1, NOPLUG);
+                if(!flat[pos]) {
+                    if((left == NOPLUG) && (up == NOPLUG)) next.add(state, count);
+                }
+                else if(pos == 0) { // the path starts
+                    if(canDown) next.add(setPlug(empty, j, SOURCEPLUG), count);
+                    if(canRight) next.add(setPlug(empty, j + 1, SOURCEPLUG), count);
+                }
+                else if(pos == dstCell) { // the path ends, nothing else may be left
+                    if(((left | up) == SOURCEPLUG) && ((left == NOPLUG) || (up == NOPLUG)) && (empty == 0)) next.add(0, count);
+                }
+                else if((left == NOPLUG) && (up == NOPLUG)) {
+                    next.add(state, count);
+                    if(canDown && canRight) next.add(setPlug(setPlug(state, j, OPENPLUG), j + 1, CLOSEPLUG), count);
+                }
+                else if((left == NOPLUG) || (up == NOPLUG)) {
+                    if(canDown) next.add(setPlug(empty, j, left | up), count);
+                    if(canRight) next.add(setPlug(empty, j + 1, left | up), count);
+                }
+                else if((left == OPENPLUG) && (up == CLOSEPLUG)) { // the two ends of one segment, a cycle
+                    continue;
+                }
+                else if((left == CLOSEPLUG) && (up == OPENPLUG)) { // two segments become one
+                    next.add(empty, count);
+                }
+                else if((left == SOURCEPLUG) || (up == OPENPLUG)) { // ( ( or source and segment: the far end of up takes left
+                    next.add(setPlug(empty, matchingPlug(state, j + 1), left), count);
+                }
+                else { // ) ) or segment and source: the far end of left takes up
+                    next.add(setPlug(empty, matchingPlug(state, j), up), count);
+                }
+            }
+            std::swap(cur, next);
+        }
+        // the right edge of the last column is never crossed, the plugs move one edge right for the next row
+        next.clear();
+        for(size_t k = 0; k < cur.size(); k++) {
+            next.add(cur.state(k) << PLUG_BITS, cur.count(k));
+        }
+        std::swap(cur, next);
+    }
+    return (cur.size() == 0) ? Counter(0) : cur.count(0);
+}
+
 // This case will cover the 3*3 matrix with 3 snakes
 void testZeroPath1() {
     constexpr int rows = 3;
@@ -227,7 +795,431 @@ void testNumPathOfRectMatrix2() {
     std::cout << "test case " << __FUNCTION__ << " total path number: " << numPaths << std::endl;
 }
 
+// This case will cover the 3*3 matrix with 1 snake, bit-packed in memory
+void testPackedGrid() {
+    constexpr int rows = 3;
+    constexpr int cols = 3;
+
+    CELLFLAG grid[rows][cols] = { {FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, SNAKE, FLATLAND}, {FLATLAND, FLATLAND, FLATLAND} };
+    PackedGrid packed(*grid, rows, cols);
+	int numPaths = printAllPaths(__FUNCTION__, packed.view());
+    std::cout << "test case " << __FUNCTION__ << " total path number: " << numPaths << std::endl;
+}
+
+// Output
+//     the number of paths of the depth first search, its printing discarded
+template<typename Grid>
+int countByPrinting(Grid grid, int rows, int columns) {
+    std::ostringstream discarded;
+    std::streambuf* console = std::cout.rdbuf(discarded.rdbuf());
+    int numPaths = printAllPaths("discarded", grid, rows, columns);
+    std::cout.rdbuf(console);
+    return numPaths;
+}
+
+// Input
+//     maxRows, maxColumns : the largest shape
+//     body                : body(grid, rows, columns) for every grid
+// Synopsis
+//     every shape up to maxRows * maxColumns with 12 patterns of snakes, the first one open
+template<typename Body>
+void forEachPatternGrid(int maxRows, int maxColumns, Body&& body) {
+    for(int rows = 1; rows <= maxRows; rows++) {
+        for(int cols = 1; cols <= maxColumns; cols++) {
+            for(unsigned pattern = 0; pattern < 12; pattern++) {
+                std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+                for(int i = 0; (pattern != 0) && (i < rows * cols); i++) {
+                    grid[i] = (((i + 1) * (pattern + 1) * 2654435761u) >> 29) < 2 ? SNAKE : FLATLAND;
+                }
+                body(grid, rows, cols);
+            }
+        }
+    }
+}
+
+// This case will cover every shape up to 4*5 with snakes, counted by the plug dynamic programming and the search,
+// and the open square grids whose numbers of paths are known
+void testFrontierCounter() {
+    forEachPatternGrid(4, 5, [](const std::vector<CELLFLAG>& grid, int rows, int cols) {
+        const int expected = countByPrinting(grid.data(), rows, cols);
+        assert(countAllPaths(grid.data(), rows, cols) == uint64_t(expected));
+        assert(countAllPaths<ModCounter>(grid.data(), rows, cols) == ModCounter(expected));
+    });
+
+    std::vector<CELLFLAG> open(11 * 11, FLATLAND);
+    assert(countAllPaths(open.data(), 4, 4) == 184);
+    assert(countAllPaths(open.data(), 7, 7) == 575780564);
+    assert(toString(countAllPaths<uint128_t>(open.data(), 11, 11)) == "1568758030464750013214100");
+    assert(toString(countAllPaths<BigCounter>(open.data(), 11, 11)) == "1568758030464750013214100");
+    PackedGrid packed(open.data(), 5, 2);
+    assert(countAllPaths(packed.view(), 5, 2) == uint64_t(countByPrinting(open.data(), 5, 2)));
+}
+
+// This case will cover every shape up to 4*5 with snakes and a 2*62 matrix with 8192 paths, the bitboard search must print
+// the text of printAllPaths and count the paths of the plug dynamic programming
+void testBitboardSearch() {
+    forEachPatternGrid(4, 5, [name = __FUNCTION__](const std::vector<CELLFLAG>& grid, int rows, int cols) {
+        std::ostringstream printed;
+        std::streambuf* console = std::cout.rdbuf(printed.rdbuf());
+        const int expected = printAllPaths(name, grid.data(), rows, cols);
+        std::cout.rdbuf(console);
+
+        std::ostringstream text;
+        TextPathSink sink(name, text);
+        assert(searchAllPaths<false>(sink, grid.data(), rows, cols) == expected);
+        assert(text.str() == printed.str());
+    });
+
+    // open for 12 columns, then a zigzag of snakes leaving one way through
+    std::vector<CELLFLAG> wide(2 * MAX_BITBOARD_COLUMNS, FLATLAND);
+    for(int j = 12; j < MAX_BITBOARD_COLUMNS - 1; j++) {
+        if(j % 4 == 1) wide[j] = SNAKE;
+        if(j % 4 == 3) wide[MAX_BITBOARD_COLUMNS + j] = SNAKE;
+    }
+    NullPathSink nullSink;
+    long long expansions = 0;
+    assert(searchAllPaths(nullSink, wide.data(), 2, MAX_BITBOARD_COLUMNS, &expansions) == 8192);
+    assert(countAllPaths(wide.data(), 2, MAX_BITBOARD_COLUMNS) == 8192);
+    assert(expansions > 0);
+}
+
+// This case will cover every shape up to 5*5 with snakes and a maze, the pruned search must print the paths
+// of the search without pruning, with no more expansions and fewer on the maze
+void testCutPruning() {
+    forEachPatternGrid(5, 5, [name = __FUNCTION__](const std::vector<CELLFLAG>& grid, int rows, int cols) {
+        std::ostringstream pruned, unpruned;
+        TextPathSink prunedSink(name, pruned);
+        TextPathSink unprunedSink(name, unpruned);
+        long long prunedExpansions = 0;
+        long long unprunedExpansions = 0;
+        const long long numPaths = searchAllPaths<true>(prunedSink, grid.data(), rows, cols, &prunedExpansions);
+        assert(searchAllPaths<false>(unprunedSink, grid.data(), rows, cols, &unprunedExpansions) == numPaths);
+        assert(pruned.str() == unpruned.str());
+        assert(prunedExpansions <= unprunedExpansions);
+    });
+
+    constexpr int rows = 5;
+    constexpr int cols = 5;
+    CELLFLAG maze[rows][cols] = { {FLATLAND, FLATLAND, FLATLAND, FLATLAND, FLATLAND}, {FLATLAND, SNAKE, SNAKE, SNAKE, FLATLAND},
+                                  {FLATLAND, FLATLAND, FLATLAND, SNAKE, FLATLAND}, {SNAKE, SNAKE, FLATLAND, SNAKE, FLATLAND},
+                                  {FLATLAND, FLATLAND, FLATLAND, SNAKE, FLATLAND} };
+    NullPathSink nullSink;
+    long long prunedExpansions = 0;
+    long long unprunedExpansions = 0;
+    assert(searchAllPaths<true>(nullSink, *maze, rows, cols, &prunedExpansions) == 1);
+    assert(searchAllPaths<false>(nullSink, *maze, rows, cols, &unprunedExpansions) == 1);
+    assert(prunedExpansions == rows + cols - 1);
+    assert(prunedExpansions < unprunedExpansions);
+}
+
+// This case will cover every shape up to 5*5 with snakes, split into few or many tasks on 1 to 3 threads,
+// and an open 6*6 matrix on 4 threads; the parallel count must be the number of paths of the search
+void testParallelCounting() {
+    forEachPatternGrid(5, 5, [](const std::vector<CELLFLAG>& grid, int rows, int cols) {
+        NullPathSink nullSink;
+        const long long expected = searchAllPaths<false>(nullSink, grid.data(), rows, cols);
+        for(int threads = 1; threads <= 3; threads++) {
+            assert(countPathsParallel<true>(grid.data(), rows, cols, threads, 1) == expected);
+            assert(countPathsParallel<true>(grid.data(), rows, cols, threads) == expected);
+            assert(countPathsParallel<false>(grid.data(), rows, cols, threads, 8) == expected);
+        }
+    });
+
+    std::vector<CELLFLAG> open(6 * 6, FLATLAND);
+    assert(countPathsParallel(open.data(), 6, 6, 4) == 1262816);
+}
+
+// Receives the paths of a search, and at the path interruptAt waits for the checkpoint writer and reads
+// the latest checkpoint as a kill at that point would leave it
+struct InterruptedSink {
+    TextPathSink& text;
+    CheckpointWriter& writer;
+    const char* file;
+    long long interruptAt;
+    SearchState& state;
+    long long numPaths;
+
+    template<typename PathCell>
+    void path(const PathCell* cells, int length) {
+        text.path(cells, length);
+        if((++numPaths) == interruptAt) {
+            writer.flush();
+            assert(readSearchState(file, state));
+        }
+    }
+
+    void finish() { text.finish(); }
+
+    long long sync() { return text.sync(); }
+};
+
+// This case will cover a 5*5 matrix with a snake checkpointed every 200 expansions and interrupted at the
+// 1000th path, the run resumed from the checkpoint must print the rest of the text of the whole run
+void testCheckpoint() {
+    constexpr int rows = 5;
+    constexpr int cols = 5;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    grid[12] = SNAKE;
+    char file[] = "/tmp/checkpoint_XXXXXX";
+    int fd = mkstemp(file);
+    assert(fd >= 0);
+    close(fd);
+
+    std::ostringstream whole;
+    TextPathSink wholeSink(__FUNCTION__, whole);
+    SearchState killed{};
+    long long result = 0;
+    {
+        CheckpointWriter writer(file, 200);
+        InterruptedSink sink{ wholeSink, writer, file, 1000, killed, 0 };
+        result = searchAllPaths(sink, grid.data(), rows, cols, nullptr, &writer);
+        writer.flush();
+        assert(writer.written() > 1);
+    }
+    assert(uint64_t(result) == countAllPaths(grid.data(), rows, cols));
+    assert((killed.numPaths > 0) && (killed.numPaths <= 1000) && !killed.pos.empty());
+
+    std::ostringstream resumed;
+    TextPathSink resumedSink(__FUNCTION__, resumed, killed.numPaths);
+    assert(searchAllPaths(resumedSink, grid.data(), rows, cols, nullptr, nullptr, &killed) == result);
+    const std::string text = whole.str();
+    size_t cut = text.find('\n'); // the name of the grid
+    for(long long n = 0; n < killed.numPaths; n++) {
+        cut = text.find('\n', cut + 1);
+    }
+    assert(text.substr(cut + 1) == resumed.str());
+
+    SearchState last;
+    assert(readSearchState(file, last));
+    assert(last.pos.empty() && (last.numPaths == result));
+    NullPathSink nullSink;
+    assert(searchAllPaths(nullSink, grid.data(), rows, cols, nullptr, nullptr, &last) == result);
+    assert(nullSink.numPaths == 0);
+    unlink(file);
+}
+
+// This case will cover a 4*4 matrix without snakes searched with counters, every cell pushed must be popped once,
+// the cut pruning must leave no dead end at all, and the workers must find every path
+void testSearchStats() {
+    constexpr int rows = 4;
+    constexpr int cols = 4;
+
+    std::vector<CELLFLAG> grid(rows * cols, FLATLAND);
+    NullPathSink nullSink;
+    long long expansions = 0;
+    CountingSearchStats plain;
+    const long long result = searchAllPaths<false>(nullSink, grid.data(), rows, cols, &expansions, nullptr, nullptr, &plain);
+    assert(result == 184);
+    assert(plain.nodes == expansions);
+    assert(plain.maxDepth == rows * cols - 2); // the corners have the same colour, so no path covers all 16 cells
+    assert(plain.backtracks[BACKTRACK_DESTINATION] == result);
+    assert(plain.backtracks[BACKTRACK_VISITED] > 0);
+    assert((plain.backtracks[BACKTRACK_BLOCKED] == 0) && (plain.backtracks[BACKTRACK_PRUNED] == 0));
+    long long popped = 0;
+    for(long long n : plain.branching) {
+        popped += n;
+    }
+    assert(popped == plain.nodes);
+
+    CountingSearchStats pruned;
+    assert(searchAllPaths<true>(nullSink, grid.data(), rows, cols, &expansions, nullptr, nullptr, &pruned) == result);
+    assert((pruned.nodes == expansions) && (pruned.nodes < plain.nodes));
+    assert(pruned.backtracks[BACKTRACK_VISITED] + pruned.backtracks[BACKTRACK_PRUNED] == 0);
+
+    CountingSearchStats parallel;
+    assert(countPathsParallel(grid.data(), rows, cols, 3, 4, &parallel) == result);
+    assert(parallel.backtracks[BACKTRACK_DESTINATION] == result); // no prefix of 4 tasks per thread reaches the destination
+
+    std::ostringstream json;
+    pruned.writeJson(json);
+    assert(json.str().find("\"destination\": 184") != std::string::npos);
+}
+
+#ifdef BENCHMARK
+#include "Benchmark.h" // for secondsOf, randomGrid, mazeGrid, BenchmarkReport
+
+// Synopsis
+//     print the seconds of the search against the plug dynamic programming, and of the plug dynamic programming
+//     on grids 12 columns wide
+void benchmarkFrontierCounter() {
+    std::vector<CELLFLAG> open(6 * 6, FLATLAND);
+    int searched = 0;
+    double seconds = secondsOf([&] { searched = countByPrinting(open.data(), 6, 6); });
+    std::cout << "search 6x6: " << searched << " paths " << seconds << " s" << std::endl;
+    seconds = secondsOf([&] { doNotOptimize(countAllPaths(open.data(), 6, 6)); });
+    std::cout << "plug dp 6x6: " << seconds << " s" << std::endl;
+
+    for(int rows : { 12, 100 }) {
+        std::vector<CELLFLAG> grid = randomGrid<CELLFLAG>(rows, 12, (rows == 12) ? 0.0 : 0.1, 13);
+        BigCounter numPaths;
+        seconds = secondsOf([&] { numPaths = countAllPaths<BigCounter>(grid.data(), rows, 12); });
+        std::cout << "plug dp " << rows << "x12: " << toString(numPaths).size() << " digits " << seconds << " s" << std::endl;
+    }
+    // the count of a tall grid has thousands of digits, modulo a prime the additions stay O(1)
+    std::vector<CELLFLAG> tall = randomGrid<CELLFLAG>(1000, 12, 0.1, 13);
+    seconds = secondsOf([&] { doNotOptimize(countAllPaths<ModCounter>(tall.data(), 1000, 12)); });
+    std::cout << "plug dp 1000x12 ModCounter: " << seconds << " s" << std::endl;
+}
+
+// Synopsis
+//     print the nodes per second of printAllPaths and of the bitboard search on a 6*6 open grid,
+//     the bitboard search printing the same text or only counting
+void benchmarkBitboardSearch() {
+    constexpr int rows = 6;
+    constexpr int cols = 6;
+    std::vector<CELLFLAG> open(rows * cols, FLATLAND);
+    NullPathSink nullSink;
+    long long expansions = 0;
+    double seconds = secondsOf([&] { searchAllPaths(nullSink, open.data(), rows, cols, &expansions); });
+    const double nodes = double(expansions);
+    std::cout << "bitboard search, counting: " << nodes / seconds / 1e6 << " Mnodes/s" << std::endl;
+    std::ostringstream discarded;
+    TextPathSink textSink("benchmark", discarded);
+    seconds = secondsOf([&] { searchAllPaths(textSink, open.data(), rows, cols); });
+    std::cout << "bitboard search, printing: " << nodes / seconds / 1e6 << " Mnodes/s" << std::endl;
+    seconds = secondsOf([&] { countByPrinting(open.data(), rows, cols); });
+    std::cout << "printAllPaths: " << nodes / seconds / 1e6 << " Mnodes/s" << std::endl;
+}
+
+// Synopsis
+//     print the expansions and the seconds of the bitboard search with and without cut pruning,
+//     on an open grid and on grids whose snakes make corridors and pockets
+void benchmarkCutPruning() {
+    auto run = [](const char* name, const std::vector<CELLFLAG>& grid, int rows, int cols) {
+        NullPathSink sink;
+        long long pruned = 0;
+        long long unpruned = 0;
+        long long numPaths = 0;
+        double prunedSeconds = secondsOf([&] { numPaths = searchAllPaths<true>(sink, grid.data(), rows, cols, &pruned); });
+        double unprunedSeconds = secondsOf([&] { searchAllPaths<false>(sink, grid.data(), rows, cols, &unpruned); });
+        std::cout << name << " " << rows << "x" << cols << ", " << numPaths << " paths: pruned " << pruned << " expansions "
+                  << prunedSeconds << " s, unpruned " << unpruned << " expansions " << unprunedSeconds << " s" << std::endl;
+    };
+    run("open", std::vector<CELLFLAG>(6 * 6, FLATLAND), 6, 6);
+    for(double density : { 0.2, 0.3 }) {
+        run(density == 0.2 ? "snakes 0.2" : "snakes 0.3", randomGrid<CELLFLAG>(9, 9, density, 14), 9, 9);
+    }
+    // walls down every other column with a gap at alternate ends, open pockets off the corridor
+    std::vector<CELLFLAG> maze(9 * 9, FLATLAND);
+    for(int j = 1; j < 9; j += 2) {
+        for(int i = 0; i < 9; i++) {
+            if(i != ((j % 4 == 1) ? 8 : 0) && (i % 4 != 2)) maze[i * 9 + j] = SNAKE;
+        }
+    }
+    run("maze", maze, 9, 9);
+}
+
+// Synopsis
+//     print the seconds of the parallel count against the single threaded search on open grids,
+//     by the number of threads
+void benchmarkParallelCounting() {
+    const unsigned cores = std::thread::hardware_concurrency();
+    std::cout << "parallel counting, " << cores << " hardware threads" << std::endl;
+    for(int cols : { 6, 7 }) {
+        constexpr int rows = 6;
+        std::vector<CELLFLAG> open(rows * cols, FLATLAND);
+        NullPathSink nullSink;
+        long long numPaths = 0;
+        const double single = secondsOf([&] { numPaths = searchAllPaths(nullSink, open.data(), rows, cols); });
+        std::cout << "  " << rows << "x" << cols << ", " << numPaths << " paths, searchAllPaths " << single << " s" << std::endl;
+        for(int threads = 1; threads <= 64; threads *= 2) {
+            long long counted = 0;
+            const double seconds = secondsOf([&] { counted = countPathsParallel(open.data(), rows, cols, threads); });
+            assert(counted == numPaths);
+            std::cout << "    " << threads << " threads: " << seconds << " s, speedup " << single / seconds << std::endl;
+            if(unsigned(threads) >= cores) break;
+        }
+    }
+}
+
+// Synopsis
+//     print the seconds of the bitboard search with and without a checkpoint every 100000 expansions
+void benchmarkCheckpoint() {
+    constexpr int rows = 6;
+    constexpr int cols = 6;
+    std::vector<CELLFLAG> open(rows * cols, FLATLAND);
+    NullPathSink nullSink;
+    double plain = secondsOf([&] { searchAllPaths(nullSink, open.data(), rows, cols); });
+    char file[] = "/tmp/checkpoint_XXXXXX";
+    int fd = mkstemp(file);
+    close(fd);
+    long long written = 0;
+    double checkpointed = secondsOf([&] {
+        CheckpointWriter writer(file, 100000);
+        searchAllPaths(nullSink, open.data(), rows, cols, nullptr, &writer);
+        writer.flush();
+        written = writer.written();
+    });
+    unlink(file);
+    std::cout << "bitboard search: " << plain << " s, checkpointed: " << checkpointed << " s, "
+              << written << " checkpoints written" << std::endl;
+}
+
+// Synopsis
+//     print the nodes per second of the search of a 6*6 open grid without and with the counters,
+//     and the counters of the latter
+void benchmarkSearchStats() {
+    constexpr int rows = 6;
+    constexpr int cols = 6;
+    const std::vector<CELLFLAG> open(rows * cols, FLATLAND);
+    NullPathSink nullSink;
+    long long expansions = 0;
+    NoSearchStats none;
+    double seconds = secondsOf([&] { searchAllPaths(nullSink, open.data(), rows, cols, &expansions, nullptr, nullptr, &none); });
+    std::cout << "search without counters: " << expansions / seconds / 1e6 << " Mnodes/s" << std::endl;
+    CountingSearchStats counted;
+    seconds = secondsOf([&] { searchAllPaths(nullSink, open.data(), rows, cols, &expansions, nullptr, nullptr, &counted); });
+    std::cout << "search with counters: " << expansions / seconds / 1e6 << " Mnodes/s, ";
+    counted.writeJson(std::cout);
+    std::cout << std::endl;
+}
+
+// Synopsis
+//     the suite of Answer-E, see Benchmark.h: the bitboard search into a NullPathSink on open, uniform and maze
+//     grids of growing size, the parallel count of the largest open grid for 1, 2, 4, ... hardware threads,
+//     and the plug dynamic programming on open grids of growing size
+void benchmarkSuite() {
+    BenchmarkReport report("Answer-E");
+    constexpr uint64_t seed = 20;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    NullPathSink sink;
+    for(int size : { 4, 5, 6 }) {
+        const std::vector<CELLFLAG> open(size * size, FLATLAND);
+        const std::vector<CELLFLAG> uniform = randomGrid<CELLFLAG>(size + 1, size + 1, 0.2, seed);
+        const std::vector<CELLFLAG> maze = mazeGrid<CELLFLAG>(2 * size + 1, 2 * size + 1, 0.3, seed);
+        report.measure({ "searchAllPaths", "open", 0, size, size, 0, 1, true },
+                       [&] { return searchAllPaths(sink, open.data(), size, size); });
+        report.measure({ "searchAllPaths", "uniform", seed, size + 1, size + 1, 0.2, 1, true },
+                       [&] { return searchAllPaths(sink, uniform.data(), size + 1, size + 1); });
+        report.measure({ "searchAllPaths", "maze", seed, 2 * size + 1, 2 * size + 1, 0.3, 1, true },
+                       [&] { return searchAllPaths(sink, maze.data(), 2 * size + 1, 2 * size + 1); });
+    }
+    constexpr int size = 6;
+    const std::vector<CELLFLAG> open(size * size, FLATLAND);
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        report.measure({ "countPathsParallel", "open", 0, size, size, 0, threads, true },
+                       [&] { return countPathsParallel(open.data(), size, size, threads); });
+    }
+    for(int columns : { 6, 8, 10, 12 }) {
+        const std::vector<CELLFLAG> wide(size_t(columns) * columns, FLATLAND);
+        report.measure({ "countAllPaths<uint128_t>", "open", 0, columns, columns, 0, 1, false },
+                       [&] { return countAllPaths<uint128_t>(wide.data(), columns, columns); });
+    }
+}
+#endif
+
 int main() {
+#ifdef BENCHMARK
+    benchmarkFrontierCounter();
+    benchmarkBitboardSearch();
+    benchmarkCutPruning();
+    benchmarkParallelCounting();
+    benchmarkCheckpoint();
+    benchmarkSearchStats();
+    benchmarkSuite();
+    return 0;
+#endif
     testZeroPath1(); // 0 path expected
     testZeroPath2(); // 0 path expected
     testZeroPath3(); // 0 path expected
@@ -235,4 +1227,11 @@ int main() {
     testFullPath();  // 6 paths expected
     testNumPathOfRectMatrix1(); // 1 path expected
     testNumPathOfRectMatrix2(); // 1 path expected
+    testPackedGrid();           // 2 paths expected
+    testFrontierCounter();      // the number of paths of the search expected
+    testBitboardSearch();       // the paths of the search expected
+    testCutPruning();           // the paths of the search expected with fewer expansions
+    testParallelCounting();     // the number of paths of the search expected
+    testCheckpoint();           // the rest of the paths expected from the checkpoint
+    testSearchStats();          // every cell pushed expected to be popped once
 }
@@ -0,0 +1,203 @@
+// Batch kernel of the path counting dynamic programming: BATCH_LANES grids of the same size counted in lockstep.
+// A GridBatch holds the grids as a structure of arrays, the flags of cell c of all the grids side by side as the
+// bits of one BATCH_LANES-bit lane mask, so the row of dp holds BATCH_LANES counters per cell and one row step of
+// every grid is a vertical operation on them:
+//     dp[j] = flag[j] ? dp[j] + dp[j-1] : 0
+// one masked add per vector of lanes, with no shuffle at all, unlike the row kernel of RowKernel.h which has
+// to carry the prefix sum across the lanes of a single row. The lane masks are 2 bytes per cell for the whole
+// batch, so a batch of large grids is read from memory at 1/32 of the bytes of its CELLFLAG grids.
+// The AVX2 and AVX-512 kernels follow rowkernel::selectedIsa(), for 32-bit (int) and 64-bit (uint64_t) counters;
+// the other counters use the scalar kernel.
+
+#ifndef BATCH_KERNEL_H
+#define BATCH_KERNEL_H
+
+#include<cassert>     // for assert
+#include<cstdint>     // for int32_t, uint16_t, uint32_t, uint64_t
+#include<immintrin.h> // for the SSE2, AVX2 and AVX-512 intrinsics
+#include<vector>      // for std::vector
+
+#include "Grid.h"      // for CELLFLAG, CacheLineAllocator
+#include "RowKernel.h" // for rowkernel::selectedIsa
+
+// 16 32-bit counters are one AVX-512 vector and one cache line
+constexpr int BATCH_LANES = 16;
+
+class GridBatch {
+public:
+    // Input
+    //     rows    : the number of matrix rows of every grid
+    //     columns : the number of matrix columns of every grid
+    GridBatch(int rows, int columns) : numRows(rows), numColumns(columns), numGrids(0),
+                                       masks(size_t(rows) * columns, 0) {
+        assert((rows > 0) && (columns > 0));
+    }
+
+    // Input
+    //     grid : the pointer which points to the matrix by row major order, rows * columns cells
+    // Output
+    //     the lane of the grid, the grids added since the batch was made or cleared fill the lanes in order
+    // Synopsis
+    //     the bit of the lane is written 8 cells at a time with SSE2, part of every x86-64 cpu:
+    //     8 flags packed to 16-bit lanes, compared with SNAKE and merged into 8 lane masks
+    int add(const CELLFLAG* grid) {
+        static_assert(sizeof(CELLFLAG) == sizeof(int32_t), "the flags are loaded as 32-bit lanes");
+        assert(numGrids < BATCH_LANES);
+        const uint16_t bit = uint16_t(1u << numGrids);
+        const int cells = numRows * numColumns;
+        const __m128i vbit = _mm_set1_epi16(short(bit));
+        int c = 0;
+        for(; c + 8 <= cells; c += 8) {
+            const __m128i flags = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(grid + c)),
+                                                  _mm_loadu_si128((const __m128i*)(grid + c + 4)));
+            const __m128i flat = _mm_andnot_si128(_mm_cmpeq_epi16(flags, _mm_setzero_si128()), vbit);
+            __m128i* m = (__m128i*)(masks.data() + c);
+            _mm_storeu_si128(m, _mm_or_si128(_mm_andnot_si128(vbit, _mm_loadu_si128(m)), flat));
+        }
+        for(; c < cells; c++) {
+            masks[c] = uint16_t((masks[c] & ~bit) | (bit & -uint16_t(grid[c] != SNAKE)));
+        }
+        return numGrids++;
+    }
+
+    // Synopsis
+    //     start a new batch of the same size; the lanes are not wiped, the grids added overwrite them,
+    //     so the lanes at or above size() hold the grids of the previous batch and their counts are meaningless
+    void clear() {
+        numGrids = 0;
+    }
+
+    int rows() const { return numRows; }
+    int columns() const { return numColumns; }
+    int size() const { return numGrids; }
+    bool full() const { return numGrids == BATCH_LANES; }
+
+    // the lane masks of row i, bit l of a cell set if it is FLATLAND in the grid of lane l
+    const uint16_t* row(int i) const { return masks.data() + size_t(i) * numColumns; }
+
+private:
+    int numRows;
+    int numColumns;
+    int numGrids;
+    std::vector<uint16_t, CacheLineAllocator<uint16_t>> masks;
+};
+
+// Input
+//     num_paths : the rows of dp, BATCH_LANES counters per cell, dp[i-1][*] on input and dp[i][*] on output
+//     masks     : the lane masks of row i, see GridBatch::row
+//     columns   : the number of cells in the row
+//     carry     : dp[i][-1] of every lane, the paths entering the row from the left
+// Synopsis
+//     the scalar kernel, also the reference of the vector kernels
+template<typename Lane>
+inline void scanBatchRowScalar(Lane* num_paths, const uint16_t* masks, int columns, Lane carry) {
+    Lane left[BATCH_LANES];
+    for(int l = 0; l < BATCH_LANES; l++) {
+        left[l] = carry;
+    }
+    for(int j = 0; j < columns; j++) {
+        Lane* dp = num_paths + size_t(j) * BATCH_LANES;
+        for(int l = 0; l < BATCH_LANES; l++) {
+            left[l] = dp[l] + left[l];
+            maskPaths(left[l], (masks[j] >> l) & 1);
+            dp[l] = left[l];
+        }
+    }
+}
+
+namespace batchkernel {
+
+// AVX2 has no mask registers, a lane mask is spread to all one or all zero lanes by testing one bit per lane
+__attribute__((target("avx2")))
+inline void scanBatchRowAvx2(uint32_t* num_paths, const uint16_t* masks, int columns, uint32_t carry) {
+    const __m256i low = _mm256_setr_epi32(1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7);
+    const __m256i high = _mm256_slli_epi32(low, 8);
+    __m256i left0 = _mm256_set1_epi32(int(carry));
+    __m256i left1 = left0;
+    for(int j = 0; j < columns; j++) {
+        __m256i* dp = (__m256i*)(num_paths + size_t(j) * BATCH_LANES);
+        const __m256i m = _mm256_set1_epi32(masks[j]);
+        const __m256i m0 = _mm256_cmpeq_epi32(_mm256_and_si256(m, low), low);
+        const __m256i m1 = _mm256_cmpeq_epi32(_mm256_and_si256(m, high), high);
+        left0 = _mm256_and_si256(m0, _mm256_add_epi32(_mm256_load_si256(dp), left0));
+        left1 = _mm256_and_si256(m1, _mm256_add_epi32(_mm256_load_si256(dp + 1), left1));
+        _mm256_store_si256(dp, left0);
+        _mm256_store_si256(dp + 1, left1);
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void scanBatchRowAvx512(uint32_t* num_paths, const uint16_t* masks, int columns, uint32_t carry) {
+    __m512i left = _mm512_set1_epi32(int(carry));
+    for(int j = 0; j < columns; j++) {
+        uint32_t* dp = num_paths + size_t(j) * BATCH_LANES;
+        left = _mm512_maskz_add_epi32(__mmask16(masks[j]), _mm512_load_si512(dp), left);
+        _mm512_store_si512(dp, left);
+    }
+}
+
+// 64-bit lanes
+__attribute__((target("avx2")))
+inline void scanBatchRowAvx2(uint64_t* num_paths, const uint16_t* masks, int columns, uint64_t carry) {
+    const __m256i bits = _mm256_setr_epi64x(1 << 0, 1 << 1, 1 << 2, 1 << 3);
+    __m256i left[BATCH_LANES / 4];
+    for(__m256i& l : left) {
+        l = _mm256_set1_epi64x((long long)carry);
+    }
+    for(int j = 0; j < columns; j++) {
+        __m256i* dp = (__m256i*)(num_paths + size_t(j) * BATCH_LANES);
+        for(int v = 0; v < BATCH_LANES / 4; v++) {
+            const __m256i m = _mm256_set1_epi64x(masks[j] >> (4 * v));
+            const __m256i wide = _mm256_cmpeq_epi64(_mm256_and_si256(m, bits), bits);
+            left[v] = _mm256_and_si256(wide, _mm256_add_epi64(_mm256_load_si256(dp + v), left[v]));
+            _mm256_store_si256(dp + v, left[v]);
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void scanBatchRowAvx512(uint64_t* num_paths, const uint16_t* masks, int columns, uint64_t carry) {
+    __m512i low = _mm512_set1_epi64((long long)carry);
+    __m512i high = low;
+    for(int j = 0; j < columns; j++) {
+        uint64_t* dp = num_paths + size_t(j) * BATCH_LANES;
+        const unsigned k = masks[j];
+        low = _mm512_maskz_add_epi64(__mmask8(k), _mm512_load_si512(dp), low);
+        high = _mm512_maskz_add_epi64(__mmask8(k >> 8), _mm512_load_si512(dp + 8), high);
+        _mm512_store_si512(dp, low);
+        _mm512_store_si512(dp + 8, high);
+    }
+}
+
+template<typename Lane>
+inline void scanBatchRowVector(Lane* num_paths, const uint16_t* masks, int columns, Lane carry) {
+    switch(rowkernel::selectedIsa()) {
+        case rowkernel::AVX512: scanBatchRowAvx512(num_paths, masks, columns, carry); break;
+        case rowkernel::AVX2:   scanBatchRowAvx2(num_paths, masks, columns, carry); break;
+        default:                scanBatchRowScalar(num_paths, masks, columns, carry); break;
+    }
+}
+
+} // namespace batchkernel
+
+// Input
+//     num_paths : the rows of dp, BATCH_LANES counters per cell on a cache line, dp[i-1][*] on input and dp[i][*] on output
+//     masks     : the lane masks of row i, see GridBatch::row
+//     columns   : the number of cells in the row
+//     carry     : dp[i][-1] of every lane
+// Synopsis
+//     scan one row of every grid of a batch with the widest kernel available for Counter
+template<typename Counter>
+inline void scanBatchRow(Counter* num_paths, const uint16_t* masks, int columns, Counter carry) {
+    scanBatchRowScalar(num_paths, masks, columns, carry);
+}
+
+inline void scanBatchRow(int* num_paths, const uint16_t* masks, int columns, int carry) {
+    batchkernel::scanBatchRowVector(reinterpret_cast<uint32_t*>(num_paths), masks, columns, uint32_t(carry));
+}
+
+inline void scanBatchRow(uint64_t* num_paths, const uint16_t* masks, int columns, uint64_t carry) {
+    batchkernel::scanBatchRowVector(num_paths, masks, columns, carry);
+}
+
+#endif
@@ -0,0 +1,252 @@
+// Helpers shared by the benchmark drivers, compiled in with -DBENCHMARK, e.g.
+//     g++ -std=c++17 -O2 -pthread -DBENCHMARK Answer-A.cc && ./a.out
+// Every driver ends with the suite of its engine, whose results are written as JSON to the file named by the
+// BENCHMARK_JSON environment variable, or to benchmark-<engine>.json; the grids of the suites come from the
+// seeded generators below, so two runs of the same commit measure the same grids and two commits can be diffed.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include<algorithm> // for std::min
+#include<cassert>   // for assert
+#include<chrono>    // for std::chrono::steady_clock
+#include<cstdint>   // for uint64_t
+#include<cstdio>    // for FILE, fopen, fgets
+#include<cstdlib>   // for getenv, atoll
+#include<cstring>   // for strncmp
+#include<fstream>   // for std::ofstream
+#include<iostream>  // for std::cout
+#include<random>    // for std::mt19937_64
+#include<string>    // for std::string
+#include<thread>    // for std::thread::hardware_concurrency
+#include<utility>   // for std::pair
+#include<vector>    // for std::vector
+#include<sys/resource.h> // for getrusage
+
+#include "PathCounter.h" // for toString
+
+// Input
+//     body : the work to be measured
+// Output
+//     the wall clock seconds spent in body
+template<typename Body>
+double secondsOf(Body&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Input
+//     rows         : the number of matrix rows
+//     columns      : the number of matrix columns
+//     snakeDensity : the probability of a cell having a snake
+//     seed         : the seed of the generator, the same seed always gives the same grid
+// Output
+//     the grid by row major order, Flag(0) for SNAKE and Flag(1) for FLATLAND; source and destination are always FLATLAND
+template<typename Flag>
+std::vector<Flag> randomGrid(int rows, int columns, double snakeDensity, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::bernoulli_distribution isSnake(snakeDensity);
+    std::vector<Flag> grid(size_t(rows) * columns);
+    for(size_t i = 0; i < grid.size(); i++) {
+        grid[i] = Flag(isSnake(rng) ? 0 : 1);
+    }
+    grid.front() = Flag(1);
+    grid.back() = Flag(1);
+    return grid;
+}
+
+// Input
+//     rows       : the number of matrix rows
+//     columns    : the number of matrix columns
+//     num_snakes : the number of snakes, duplicates are possible
+//     seed       : the seed of the generator, the same seed always gives the same snakes
+// Output
+//     the (row, column) of every snake, never the source or the destination
+inline std::vector<std::pair<int, int>> randomSnakes(int rows, int columns, int num_snakes, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> row(0, rows - 1);
+    std::uniform_int_distribution<int> column(0, columns - 1);
+    std::vector<std::pair<int, int>> snakes;
+    snakes.reserve(num_snakes);
+    while(int(snakes.size()) < num_snakes) {
+        std::pair<int, int> snake(row(rng), column(rng));
+        if((snake != std::pair<int, int>(0, 0)) && (snake != std::pair<int, int>(rows - 1, columns - 1))) {
+            snakes.push_back(snake);
+        }
+    }
+    return snakes;
+}
+
+// Input
+//     rows     : the number of matrix rows, odd
+//     columns  : the number of matrix columns, odd
+//     openings : the probability of a wall between two rooms being opened after the maze is carved
+//     seed     : the seed of the generator, the same seed always gives the same maze
+// Output
+//     the grid by row major order, Flag(0) for SNAKE and Flag(1) for FLATLAND
+// Synopsis
+//     the cells of even row and column are rooms, and the cells between two rooms are walls. A depth first
+//     search from the source carves a perfect maze, one simple path between any two rooms, and every wall left
+//     is then opened with the probability openings, which makes loops and so more paths
+template<typename Flag>
+std::vector<Flag> mazeGrid(int rows, int columns, double openings, uint64_t seed) {
+    assert((rows % 2 == 1) && (columns % 2 == 1));
+    std::mt19937_64 rng(seed);
+    std::vector<Flag> grid(size_t(rows) * columns, Flag(0));
+    const int di[4] = { 0, 2, 0, -2 };
+    const int dj[4] = { 2, 0, -2, 0 };
+    std::vector<std::pair<int, int>> stack(1, std::pair<int, int>(0, 0));
+    grid[0] = Flag(1);
+    while(!stack.empty()) {
+        const int i = stack.back().first;
+        const int j = stack.back().second;
+        int next[4];
+        int numNext = 0;
+        for(int d = 0; d < 4; d++) {
+            const int ni = i + di[d];
+            const int nj = j + dj[d];
+            if((ni >= 0) && (ni < rows) && (nj >= 0) && (nj < columns) && (grid[size_t(ni) * columns + nj] == Flag(0))) {
+                next[numNext++] = d;
+            }
+        }
+        if(numNext == 0) {
+            stack.pop_back();
+            continue;
+        }
+        const int d = next[rng() % numNext];
+        grid[size_t(i + di[d] / 2) * columns + j + dj[d] / 2] = Flag(1);
+        grid[size_t(i + di[d]) * columns + j + dj[d]] = Flag(1);
+        stack.emplace_back(i + di[d], j + dj[d]);
+    }
+    std::bernoulli_distribution isOpened(openings);
+    for(int i = 0; i < rows; i++) {
+        for(int j = (i + 1) % 2; j < columns; j += 2) { // the walls, one coordinate odd and the other even
+            if((grid[size_t(i) * columns + j] == Flag(0)) && isOpened(rng)) {
+                grid[size_t(i) * columns + j] = Flag(1);
+            }
+        }
+    }
+    return grid;
+}
+
+// Output
+//     the largest resident set of the process, in KiB, since the last resetPeakRss()
+inline long long peakRssKb() {
+    FILE* status = fopen("/proc/self/status", "r");
+    if(status != nullptr) {
+        char line[256];
+        long long kb = -1;
+        while(fgets(line, sizeof(line), status) != nullptr) {
+            if(strncmp(line, "VmHWM:", 6) == 0) kb = atoll(line + 6);
+        }
+        fclose(status);
+        if(kb >= 0) return kb;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // the peak of the whole process where /proc is missing
+}
+
+// Synopsis
+//     start a new peak resident set, so that the peak of one measurement does not hide the next one
+inline void resetPeakRss() {
+    FILE* clear = fopen("/proc/self/clear_refs", "w");
+    if(clear == nullptr) return;
+    fputs("5", clear);
+    fclose(clear);
+}
+
+constexpr int BENCHMARK_REPEATS = 3;
+
+// One measurement of a suite
+struct BenchmarkCase {
+    std::string name;      // the engine entry point, e.g. "countAllPaths<ModCounter>"
+    std::string generator; // open, uniform, maze or snakes
+    uint64_t seed;
+    int rows;
+    int columns;
+    double density;        // the snake density of uniform, the openings of maze, the snakes per cell of snakes
+    int threads;
+    bool enumerates;       // true if the engine goes through the paths one by one, so paths per second means something
+};
+
+// The results of the suite of one engine, written as JSON by the destructor:
+//     { "engine": ..., "compiler": ..., "hardware_threads": ..., "results": [ { ... }, ... ] }
+// every result being its BenchmarkCase, seconds, count, cells_per_second, paths_per_second and peak_rss_kb
+class BenchmarkReport {
+public:
+    explicit BenchmarkReport(const char* engine) : engine(engine) {}
+    ~BenchmarkReport() { write(); }
+    BenchmarkReport(const BenchmarkReport&) = delete;
+    BenchmarkReport& operator=(const BenchmarkReport&) = delete;
+
+    // Input
+    //     what : the measurement
+    //     body : the work to be measured, it returns the number of paths as any counter of PathCounter.h
+    // Synopsis
+    //     keep the fastest of BENCHMARK_REPEATS runs of body and the peak resident set of the process over them,
+    //     the grids of the measurement included, print the result and keep it for the JSON
+    template<typename Body>
+    void measure(const BenchmarkCase& what, Body&& body) {
+        decltype(body()) count{};
+        Result result{ what, 0, "", 0, 0 };
+        resetPeakRss();
+        for(int run = 0; run < BENCHMARK_REPEATS; run++) {
+            const double seconds = secondsOf([&] { count = body(); });
+            result.seconds = (run == 0) ? seconds : std::min(result.seconds, seconds);
+        }
+        result.peakRssKb = peakRssKb();
+        result.count = toString(count);
+        result.pathsPerSecond = what.enumerates ? std::stod(result.count) / result.seconds : 0;
+        std::cout << what.name << ", " << what.generator << " " << what.rows << "x" << what.columns << " " << what.density
+                  << ", " << what.threads << " threads: " << result.seconds << " s, " << result.count << " paths, "
+                  << cellsPerSecond(result) << " cells/s, " << result.pathsPerSecond << " paths/s, "
+                  << result.peakRssKb << " KiB" << std::endl;
+        results.push_back(result);
+    }
+
+private:
+    struct Result {
+        BenchmarkCase what;
+        double seconds;
+        std::string count;
+        double pathsPerSecond;
+        long long peakRssKb;
+    };
+
+    static double cellsPerSecond(const Result& result) {
+        return double(result.what.rows) * result.what.columns / result.seconds;
+    }
+
+    void write() const {
+        const char* path = getenv("BENCHMARK_JSON");
+        const std::string file = (path != nullptr) ? std::string(path) : "benchmark-" + engine + ".json";
+        std::ofstream out(file);
+        out << "{\n  \"engine\": \"" << engine << "\",\n  \"compiler\": \"" << __VERSION__ << "\",\n"
+            << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"results\": [";
+        for(size_t k = 0; k < results.size(); k++) {
+            const Result& r = results[k];
+            out << (k == 0 ? "\n" : ",\n") << "    { \"name\": \"" << r.what.name << "\", \"generator\": \""
+                << r.what.generator << "\", \"seed\": " << r.what.seed << ", \"rows\": " << r.what.rows
+                << ", \"columns\": " << r.what.columns << ", \"density\": " << r.what.density
+                << ", \"threads\": " << r.what.threads << ", \"seconds\": " << r.seconds << ", \"count\": \""
+                << r.count << "\", \"cells_per_second\": " << cellsPerSecond(r) << ", \"paths_per_second\": "
+                << r.pathsPerSecond << ", \"peak_rss_kb\": " << r.peakRssKb << " }";
+        }
+        out << "\n  ]\n}\n";
+        std::cout << results.size() << " results written to " << file << std::endl;
+    }
+
+    const std::string engine;
+    std::vector<Result> results;
+};
+
+// Synopsis
+//     keep the optimizer from dropping a result that is never read
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
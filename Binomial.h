@@ -0,0 +1,246 @@
+// Binomial coefficients modulo a prime from factorial and inverse factorial tables.
+// Without snakes the number of monotone paths between two cells is C(dr + dc, dr),
+// dr and dc being the row and column distances.
+//     BinomialTable   : the whole tables up to maxN, maxN below the prime
+//     SparseBinomial  : any n, by Lucas' theorem, with the factorials of only the arguments asked beforehand
+//     BlockedBinomial : any n, by Lucas' theorem, asked at any time, with every FACTORIAL_BLOCK-th factorial
+
+#ifndef BINOMIAL_H
+#define BINOMIAL_H
+
+#include<algorithm> // for std::sort, std::unique, std::lower_bound, std::min
+#include<cassert>   // for assert
+#include<cstdint>   // for int64_t, uint32_t
+#include<vector>    // for std::vector
+
+#include "PathCounter.h" // for MontgomeryCounter
+
+template<typename Counter>
+class BinomialTable {
+public:
+    // Input
+    //     maxN : the largest n of C(n, k) to be asked, it must be below the modulus
+    explicit BinomialTable(int maxN) : fact(maxN + 1), invFact(maxN + 1) {
+        assert(maxN >= 0);
+        fact[0] = Counter(1);
+        for(int n = 1; n <= maxN; n++) {
+            fact[n] = fact[n - 1] * Counter(uint64_t(n));
+        }
+        assert(fact[maxN] != Counter(0)); // maxN is below the modulus
+        invFact[maxN] = fact[maxN].inverse();
+        for(int n = maxN; n > 0; n--) {
+            invFact[n - 1] = invFact[n] * Counter(uint64_t(n));
+        }
+    }
+
+    int maxN() const { return int(fact.size()) - 1; }
+
+    // Output
+    //     C(n, k), zero if k is out of [0, n]
+    Counter choose(int n, int k) const {
+        assert(n <= maxN());
+        if((k < 0) || (k > n)) return Counter(0);
+        return fact[n] * invFact[k] * invFact[n - k];
+    }
+
+    // Input
+    //     fromRow, fromColumn : the start cell
+    //     toRow, toColumn     : the end cell
+    // Output
+    //     the number of monotone paths between the two cells without snakes, zero if the end is not reachable
+    Counter paths(int fromRow, int fromColumn, int toRow, int toColumn) const {
+        const int dr = toRow - fromRow;
+        const int dc = toColumn - fromColumn;
+        if((dr < 0) || (dc < 0)) return Counter(0);
+        return choose(dr + dc, dr);
+    }
+
+private:
+    std::vector<Counter> fact;
+    std::vector<Counter> invFact;
+};
+
+// C(n, k) modulo the prime p of Counter for n of any size, e.g. the 2e9 - 2 steps of a 1e9 x 1e9 grid.
+// By Lucas' theorem C(n, k) = C(n / p, k / p) * C(n % p, k % p) mod p, so only factorials of residues below p
+// are needed. The coefficients are declared with need() or needPaths() first; prepare() then computes the
+// factorials of their residues by one sweep up to the largest residue, O(largest residue) time and
+// O(coefficients declared) memory, where BinomialTable would keep n + 1 of each.
+template<typename Counter>
+class SparseBinomial {
+public:
+    static constexpr int64_t PRIME = IsModCounter<Counter>::MODULUS;
+
+    // Synopsis
+    //     declare C(n, k), to be asked after prepare()
+    void need(int64_t n, int64_t k) {
+        if((k < 0) || (k > n)) return;
+        for(; n > 0; n /= PRIME, k /= PRIME) {
+            const int64_t n0 = n % PRIME;
+            const int64_t k0 = k % PRIME;
+            if(k0 > n0) return; // a zero digit, C(n, k) is 0 mod p
+            residues.push_back(uint32_t(n0));
+            residues.push_back(uint32_t(k0));
+            residues.push_back(uint32_t(n0 - k0));
+        }
+    }
+
+    // Synopsis
+    //     declare the paths between two cells, see paths()
+    void needPaths(int fromRow, int fromColumn, int toRow, int toColumn) {
+        const int64_t dr = int64_t(toRow) - fromRow;
+        const int64_t dc = int64_t(toColumn) - fromColumn;
+        if((dr >= 0) && (dc >= 0)) need(dr + dc, dr);
+    }
+
+    // Synopsis
+    //     compute the factorials and inverse factorials of every residue declared
+    void prepare() {
+        residues.push_back(0);
+        std::sort(residues.begin(), residues.end());
+        residues.erase(std::unique(residues.begin(), residues.end()), residues.end());
+        fact.resize(residues.size());
+        invFact.resize(residues.size());
+        Counter f(1);
+        Counter value(0); // the Counter of v, stepped by one addition instead of one conversion
+        size_t next = 0;
+        for(uint32_t v = 0; next < residues.size(); v++) {
+            if(v > 0) f *= value;
+            if(residues[next] == v) {
+                fact[next] = f;
+                invFact[next] = f.inverse();
+                next++;
+            }
+            value += Counter(1);
+        }
+    }
+
+    // Output
+    //     C(n, k), zero if k is out of [0, n]; C(n, k) must have been declared before prepare()
+    Counter choose(int64_t n, int64_t k) const {
+        if((k < 0) || (k > n)) return Counter(0);
+        Counter result(1);
+        for(; n > 0; n /= PRIME, k /= PRIME) {
+            const int64_t n0 = n % PRIME;
+            const int64_t k0 = k % PRIME;
+            if(k0 > n0) return Counter(0);
+            result *= fact[slot(n0)] * invFact[slot(k0)] * invFact[slot(n0 - k0)];
+        }
+        return result;
+    }
+
+    // Output
+    //     the number of monotone paths between the two cells without snakes, zero if the end is not reachable
+    Counter paths(int fromRow, int fromColumn, int toRow, int toColumn) const {
+        const int64_t dr = int64_t(toRow) - fromRow;
+        const int64_t dc = int64_t(toColumn) - fromColumn;
+        if((dr < 0) || (dc < 0)) return Counter(0);
+        return choose(dr + dc, dr);
+    }
+
+private:
+    size_t slot(int64_t residue) const {
+        const auto found = std::lower_bound(residues.begin(), residues.end(), uint32_t(residue));
+        assert((found != residues.end()) && (*found == uint32_t(residue))); // declared with need()
+        return size_t(found - residues.begin());
+    }
+
+    std::vector<uint32_t> residues; // sorted and unique once prepared
+    std::vector<Counter> fact;
+    std::vector<Counter> invFact;
+};
+
+// C(n, k) modulo the prime p of Counter for n of any size and coefficients not known in advance, e.g. the queries
+// of a prepared 1e9 x 1e9 grid. By Lucas' theorem only factorials of residues below p are needed; the factorial of
+// every FACTORIAL_BLOCK-th residue up to min(maxN, p - 1) is kept and the others are one of them times at most
+// FACTORIAL_BLOCK - 1 factors. O(min(maxN, p) / FACTORIAL_BLOCK) memory, O(min(maxN, p)) time to build and
+// O(FACTORIAL_BLOCK + log p) per coefficient.
+template<typename Counter>
+class BlockedBinomial {
+public:
+    static constexpr int64_t PRIME = IsModCounter<Counter>::MODULUS;
+    static constexpr int64_t FACTORIAL_BLOCK = 1024;
+
+    // Input
+    //     maxN : the largest n of C(n, k) to be asked
+    explicit BlockedBinomial(int64_t maxN) : top(std::min(maxN, PRIME - 1)) {
+        assert(maxN >= 0);
+        const size_t numBlocks = size_t(top / FACTORIAL_BLOCK) + 1;
+        blocks.reserve(numBlocks);
+        blocks.push_back(Counter(1));
+        while(blocks.size() < numBlocks) {
+            const int64_t first = int64_t(blocks.size() - 1) * FACTORIAL_BLOCK + 1;
+            blocks.push_back(blocks.back() * productOf(first));
+        }
+    }
+
+    // Output
+    //     C(n, k), zero if k is out of [0, n]; n is at most maxN
+    Counter choose(int64_t n, int64_t k) const {
+        if((k < 0) || (k > n)) return Counter(0);
+        Counter numerator(1);
+        Counter denominator(1);
+        for(; n > 0; n /= PRIME, k /= PRIME) {
+            const int64_t n0 = n % PRIME;
+            const int64_t k0 = k % PRIME;
+            if(k0 > n0) return Counter(0);
+            numerator *= factorial(n0);
+            denominator *= factorial(k0) * factorial(n0 - k0);
+        }
+        return numerator * denominator.inverse();
+    }
+
+    // Output
+    //     the number of monotone paths between the two cells without snakes, zero if the end is not reachable
+    Counter paths(int fromRow, int fromColumn, int toRow, int toColumn) const {
+        const int64_t dr = int64_t(toRow) - fromRow;
+        const int64_t dc = int64_t(toColumn) - fromColumn;
+        if((dr < 0) || (dc < 0)) return Counter(0);
+        return choose(dr + dc, dr);
+    }
+
+private:
+    static constexpr int LANES = 8;
+    static_assert(FACTORIAL_BLOCK % LANES == 0, "a block is LANES interleaved products");
+
+    // Output
+    //     first * (first + 1) * ... * (first + FACTORIAL_BLOCK - 1), as LANES independent products, so that the
+    //     latency of a multiplication hides behind the other ones
+    static Counter productOf(int64_t first) {
+        Counter product[LANES];
+        Counter factor[LANES];
+        for(int lane = 0; lane < LANES; lane++) {
+            product[lane] = Counter(1);
+            factor[lane] = Counter(uint64_t(first + lane));
+        }
+        const Counter step(LANES);
+        for(int64_t i = 0; i < FACTORIAL_BLOCK; i += LANES) {
+            for(int lane = 0; lane < LANES; lane++) {
+                product[lane] *= factor[lane];
+                factor[lane] += step;
+            }
+        }
+        for(int width = LANES / 2; width > 0; width /= 2) {
+            for(int lane = 0; lane < width; lane++) {
+                product[lane] *= product[lane + width];
+            }
+        }
+        return product[0];
+    }
+
+    Counter factorial(int64_t residue) const {
+        assert(residue <= top);
+        const int64_t block = residue / FACTORIAL_BLOCK;
+        Counter result = blocks[size_t(block)];
+        Counter factor(uint64_t(block * FACTORIAL_BLOCK + 1));
+        for(int64_t i = block * FACTORIAL_BLOCK + 1; i <= residue; i++) {
+            result *= factor;
+            factor += Counter(1);
+        }
+        return result;
+    }
+
+    int64_t top;                 // the largest residue whose factorial can be asked
+    std::vector<Counter> blocks; // blocks[b] = (b * FACTORIAL_BLOCK)!
+};
+
+#endif
@@ -0,0 +1,226 @@
+// Checkpoints of the depth first path searches.
+// The whole state of a search is its stack: the cell of every step and the moves of the cell not tried yet,
+// plus the numbers of paths and expansions so far; the visited flags are the cells on the stack.
+// A search handed a CheckpointWriter offers its stack every interval expansions, the writer thread saves the
+// latest one while the search goes on, and a search handed a SearchState read back from the file goes on from it:
+// it emits the paths after the first numPaths ones, the same paths as the run which wrote the checkpoint.
+// Before a state is offered the sink of the search writes its buffer out with sink.sync(), see PathSink.h, and
+// the bytes of its output are kept in the state: after a kill the output may hold more paths than the latest
+// checkpoint, or fewer were it not synced, so a resume first cuts the output back to outputBytes with
+// truncateOutput and appends to it from there. The sync hands the bytes to the kernel, which keeps them
+// over a kill of the process; neither file is fsynced, so a crash of the machine is not covered.
+//
+// File format, little endian:
+//     offset  0 : magic "RGHC"
+//     offset  4 : uint32 version, CHECKPOINT_VERSION
+//     offset  8 : uint32 rows
+//     offset 12 : uint32 columns
+//     offset 16 : uint64 number of paths emitted
+//     offset 24 : uint64 number of expansions
+//     offset 32 : uint64 bytes of the output of the sink once synced, the first numPaths paths
+//     offset 40 : uint32 depth, the number of cells on the stack, 0 once the search is over
+//     offset 44 : depth int32 cells, bottom first
+//     then      : depth uint8 moves not tried yet, in the bits of the search which wrote it
+// The file is written to path.tmp and renamed over path, so a kill leaves the previous checkpoint whole.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include<condition_variable> // for std::condition_variable
+#include<cstdint>            // for uint8_t, uint32_t, uint64_t
+#include<cstdio>             // for FILE, fopen, fwrite, fread, rename
+#include<cstring>            // for memcmp
+#include<mutex>              // for std::mutex
+#include<string>             // for std::string
+#include<thread>             // for std::thread
+#include<utility>            // for std::swap
+#include<vector>             // for std::vector
+#include<unistd.h>           // for truncate
+
+constexpr uint32_t CHECKPOINT_VERSION = 2;
+constexpr char CHECKPOINT_MAGIC[4] = { 'R', 'G', 'H', 'C' };
+
+struct SearchState {
+    int rows;
+    int columns;
+    long long numPaths;
+    long long expansions;
+    long long outputBytes;    // the bytes of the output of the sink holding the first numPaths paths
+    std::vector<int> pos;     // the cells on the stack, bottom first
+    std::vector<uint8_t> adj; // the moves of every cell on the stack not tried yet
+};
+
+// Input
+//     path  : the checkpoint file to be written
+//     state : the state of the search
+// Output
+//     true if the whole file is written and renamed into place
+inline bool writeSearchState(const char* path, const SearchState& state) {
+    const std::string temporary = std::string(path) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(file == nullptr) return false;
+    const uint32_t header[3] = { CHECKPOINT_VERSION, uint32_t(state.rows), uint32_t(state.columns) };
+    const uint64_t counts[3] = { uint64_t(state.numPaths), uint64_t(state.expansions), uint64_t(state.outputBytes) };
+    const uint32_t depth = uint32_t(state.pos.size());
+    bool ok = (fwrite(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1, file) == 1)
+           && (fwrite(header, sizeof(header), 1, file) == 1)
+           && (fwrite(counts, sizeof(counts), 1, file) == 1)
+           && (fwrite(&depth, sizeof(depth), 1, file) == 1)
+           && (fwrite(state.pos.data(), sizeof(int), depth, file) == depth)
+           && (fwrite(state.adj.data(), sizeof(uint8_t), depth, file) == depth);
+    ok = (fclose(file) == 0) && ok;
+    return ok && (rename(temporary.c_str(), path) == 0);
+}
+
+// Input
+//     path  : the checkpoint file
+//     state : the state to be read
+// Output
+//     true if the file is a whole checkpoint
+inline bool readSearchState(const char* path, SearchState& state) {
+    FILE* file = fopen(path, "rb");
+    if(file == nullptr) return false;
+    char magic[4];
+    uint32_t header[3];
+    uint64_t counts[3];
+    uint32_t depth = 0;
+    bool ok = (fread(magic, sizeof(magic), 1, file) == 1) && (memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0)
+           && (fread(header, sizeof(header), 1, file) == 1) && (header[0] == CHECKPOINT_VERSION)
+           && (fread(counts, sizeof(counts), 1, file) == 1)
+           && (fread(&depth, sizeof(depth), 1, file) == 1) && (uint64_t(depth) <= uint64_t(header[1]) * header[2]);
+    if(ok) {
+        state.rows = int(header[1]);
+        state.columns = int(header[2]);
+        state.numPaths = (long long)counts[0];
+        state.expansions = (long long)counts[1];
+        state.outputBytes = (long long)counts[2];
+        state.pos.resize(depth);
+        state.adj.resize(depth);
+        ok = (fread(state.pos.data(), sizeof(int), depth, file) == depth)
+          && (fread(state.adj.data(), sizeof(uint8_t), depth, file) == depth);
+    }
+    fclose(file);
+    return ok;
+}
+
+// Input
+//     path  : the output file of the sink of the run which wrote the checkpoint
+//     state : the checkpoint the search is resumed from
+// Output
+//     true if the file is cut back to the paths the checkpoint counts, it is then opened for appending and
+//     handed to the sink of the resumed search with state.numPaths and state.outputBytes
+inline bool truncateOutput(const char* path, const SearchState& state) {
+    return truncate(path, off_t(state.outputBytes)) == 0;
+}
+
+// Saves the states offered by a search on its own thread.
+// offer() copies the stack and hands it over with a try_lock, so the search never waits for the disk:
+// if the writer holds the lock the search tries again at its next step, and a state offered while the
+// previous one is still being written replaces it.
+class CheckpointWriter {
+public:
+    // Input
+    //     path     : the checkpoint file
+    //     interval : the number of expansions between two states offered
+    CheckpointWriter(const char* path, long long interval)
+        : path(path), interval(interval), nextAt(interval), hasPending(false), writing(false), stopping(false), numWritten(0),
+          writer(&CheckpointWriter::run, this) {}
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    bool due(long long expansions) const { return expansions >= nextAt; }
+
+    // Input
+    //     paths       : the stack of the search, paths[k].pos and paths[k].adj
+    //     depth       : the number of cells on the stack
+    //     rows        : the number of matrix rows
+    //     columns     : the number of matrix columns
+    //     numPaths    : the number of paths emitted
+    //     expansions  : the number of expansions
+    //     outputBytes : the bytes of the output of the sink, synced by the search before the offer
+    //     wait        : true to wait for the lock, the last state of a search must not be dropped
+    // Output
+    //     true if the state is handed over to the writer
+    template<typename Cell>
+    bool offer(const Cell* paths, int depth, int rows, int columns, long long numPaths, long long expansions,
+               long long outputBytes, bool wait = false) {
+        staging.rows = rows;
+        staging.columns = columns;
+        staging.numPaths = numPaths;
+        staging.expansions = expansions;
+        staging.outputBytes = outputBytes;
+        staging.pos.resize(depth);
+        staging.adj.resize(depth);
+        for(int k = 0; k < depth; k++) {
+            staging.pos[k] = paths[k].pos;
+            staging.adj[k] = uint8_t(paths[k].adj);
+        }
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if(wait) lock.lock();
+        else if(!lock.try_lock()) return false;
+        std::swap(staging, pending);
+        hasPending = true;
+        nextAt = expansions + interval;
+        lock.unlock();
+        wake.notify_one();
+        return true;
+    }
+
+    // Synopsis
+    //     wait until every state handed over is on disk
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return !hasPending && !writing; });
+    }
+
+    // the number of files written, failed writes excluded
+    long long written() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return numWritten;
+    }
+
+private:
+    void run() {
+        SearchState current;
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;) {
+            wake.wait(lock, [this] { return hasPending || stopping; });
+            if(!hasPending) break;
+            std::swap(current, pending);
+            hasPending = false;
+            writing = true;
+            lock.unlock();
+            const bool ok = writeSearchState(path.c_str(), current);
+            lock.lock();
+            writing = false;
+            numWritten += ok;
+            idle.notify_all();
+        }
+    }
+
+    const std::string path;
+    const long long interval;
+    long long nextAt;        // the search thread only
+    SearchState staging;     // the search thread only
+    SearchState pending;     // under mutex
+    bool hasPending;
+    bool writing;
+    bool stopping;
+    long long numWritten;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::thread writer;
+};
+
+#endif
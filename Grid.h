@@ -0,0 +1,130 @@
+// The grid shared by the answers: the flag of a cell and the sentinel padded matrix the search engines run on.
+//
+// PaddedGrid layout, one CELLFLAG per cell:
+//     row -1 and row rows are SNAKE, and every row is followed by SNAKE up to the stride, a multiple of
+//     PADDED_ROW_CELLS cells, so the SNAKE after row i - 1 is also the one before row i.
+//     One leading cache line of SNAKE comes before row -1, so (-1, -1) is inside the storage too.
+//     The cell (i, j) is PADDED_ROW_CELLS + (i + 1) * stride + j, so the four neighbours of any cell of the
+//     matrix are +1, +stride, -1 and -stride, and every cell (i, j) of the border, -1 <= i <= rows and
+//     -1 <= j <= columns, is inside the storage, with no bounds check and no modulo.
+//     The storage and so every row start on a cache line.
+
+#ifndef GRID_H
+#define GRID_H
+
+#include<cassert> // for assert
+#include<cstddef> // for size_t
+#include<new>     // for std::align_val_t
+#include<vector>  // for std::vector
+
+enum CELLFLAG {
+    SNAKE,
+    FLATLAND
+};
+
+constexpr size_t CACHE_LINE_BYTES = 64;
+constexpr int PADDED_ROW_CELLS = int(CACHE_LINE_BYTES / sizeof(CELLFLAG));
+
+// std::allocator on cache line boundaries
+template<typename T>
+struct CacheLineAllocator {
+    typedef T value_type;
+
+    CacheLineAllocator() = default;
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(CACHE_LINE_BYTES)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(CACHE_LINE_BYTES));
+    }
+
+    template<typename U>
+    bool operator==(const CacheLineAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
+
+class PaddedGrid {
+public:
+    // Input
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    //     flag    : the flag of every cell of the matrix, the border is SNAKE whatever it is
+    PaddedGrid(int rows, int columns, CELLFLAG flag)
+        : numRows(rows), numColumns(columns), rowStride((columns / PADDED_ROW_CELLS + 1) * PADDED_ROW_CELLS),
+          cells(PADDED_ROW_CELLS + size_t(rows + 2) * rowStride, SNAKE) {
+        assert((rows >= 0) && (columns >= 0));
+        for(int i = 0; i < rows; i++) {
+            for(int j = 0; j < columns; j++) {
+                cells[cell(i, j)] = flag;
+            }
+        }
+    }
+
+    // Input
+    //     grid    : the pointer which points to the matrix by row major order, or the PackedGridView of the matrix,
+    //               any grid whose grid[pos] is 0 for SNAKE; taken by value, so a row of a CELLFLAG[rows][columns]
+    //               array decays to the pointer of the whole matrix instead of binding as one row
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    template<typename Grid>
+    PaddedGrid(Grid grid, int rows, int columns) : PaddedGrid(rows, columns, SNAKE) {
+        for(int i = 0; i < rows; i++) {
+            for(int j = 0; j < columns; j++) {
+                cells[cell(i, j)] = (grid[i * columns + j] != SNAKE) ? FLATLAND : SNAKE;
+            }
+        }
+    }
+
+    int rows() const { return numRows; }
+    int columns() const { return numColumns; }
+
+    // the offset of the downwards neighbour, the upwards one is -stride() and the rightwards and leftwards ones +1 and -1
+    int stride() const { return rowStride; }
+
+    // Output
+    //     the index of the cell (row, column), row and column may be -1 or rows and columns for the border
+    int cell(int row, int column) const { return PADDED_ROW_CELLS + (row + 1) * rowStride + column; }
+
+    // Input
+    //     pos : the cell index by row major order
+    // Output
+    //     the index of the same cell here
+    int cellOf(int pos) const {
+        const int row = pos / numColumns;
+        return cell(row, pos - row * numColumns);
+    }
+
+    // Input
+    //     c : the index of a cell of the matrix
+    // Output
+    //     the cell index by row major order
+    int posOf(int c) const {
+        const int row = (c - PADDED_ROW_CELLS) / rowStride - 1;
+        return row * numColumns + (c - cell(row, 0));
+    }
+
+    int source() const { return cell(0, 0); }
+    int destination() const { return cell(numRows - 1, numColumns - 1); }
+
+    CELLFLAG operator[](int c) const { return cells[c]; }
+    CELLFLAG& operator[](int c) { return cells[c]; }
+
+    // the first cell of row i, on a cache line, as the row kernels read a CELLFLAG row
+    const CELLFLAG* row(int i) const { return cells.data() + cell(i, 0); }
+
+    // the number of cells of the storage, border included
+    size_t size() const { return cells.size(); }
+
+private:
+    int numRows;
+    int numColumns;
+    int rowStride;
+    std::vector<CELLFLAG, CacheLineAllocator<CELLFLAG>> cells;
+};
+
+#endif
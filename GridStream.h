@@ -0,0 +1,209 @@
+// Packed grid read as a stream of rows, from a file or a pipe, for the grids which are counted once from
+// top to bottom and need not be in memory: a 1e6 x 1e4 grid is 1.25 GB packed but only one row of dp.
+// The stream is the on-disk format of PackedGrid.h, header then rows of words. A reader thread fills one of
+// two chunks of rows while the engine scans the other one, so the reads overlap the compute and the memory
+// is the two chunks whatever the size of the grid. The reader polls the stream together with a wakeup pipe, so
+// close() stops it even while a pipe whose writer is still open has no data.
+
+#ifndef GRID_STREAM_H
+#define GRID_STREAM_H
+
+#include<algorithm>          // for std::max, std::min
+#include<cerrno>             // for errno, EINTR
+#include<condition_variable> // for std::condition_variable
+#include<cstdint>            // for uint64_t
+#include<cstring>            // for memcmp
+#include<mutex>              // for std::mutex
+#include<thread>             // for std::thread
+#include<vector>             // for std::vector
+#include<fcntl.h>            // for open, posix_fadvise
+#include<poll.h>             // for poll
+#include<unistd.h>           // for read, write, close, pipe
+
+#include "PackedGrid.h" // for PackedGridHeader, PackedGridView, packedWordsPerRow
+
+class GridStream {
+public:
+    // the default bytes of a chunk, a few hundred kB keep the read of the next chunk in flight long enough
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+
+    GridStream() : fd(-1), ownsFd(false), wake{ -1, -1 }, numRows(0), numColumns(0), wordsPerRow(0), rowsPerChunk(0),
+                   rowsQueued(0), consumed(-1), stopping(false), failed(false) {}
+    ~GridStream() { close(); }
+    GridStream(const GridStream&) = delete;
+    GridStream& operator=(const GridStream&) = delete;
+
+    // Input
+    //     path       : the packed grid file
+    //     chunkBytes : the bytes of a chunk of rows, at least one row
+    // Output
+    //     true if the header is valid and the reads are started
+    bool open(const char* path, size_t chunkBytes = CHUNK_BYTES) {
+        close();
+        int opened = ::open(path, O_RDONLY);
+        if(opened < 0) return false;
+        posix_fadvise(opened, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if(!open(opened, chunkBytes)) {
+            ::close(opened);
+            return false;
+        }
+        ownsFd = true;
+        return true;
+    }
+
+    // Input
+    //     descriptor : the file or the pipe the grid is read from, e.g. 0 for stdin; it is not closed
+    //     chunkBytes : the bytes of a chunk of rows, at least one row
+    // Output
+    //     true if the header is valid and the reads are started
+    bool open(int descriptor, size_t chunkBytes = CHUNK_BYTES) {
+        close();
+        PackedGridHeader header;
+        if(!readFully(descriptor, &header, sizeof(header))) return false;
+        const bool valid = (memcmp(header.magic, PACKED_GRID_MAGIC, sizeof(header.magic)) == 0)
+                        && (header.version == PACKED_GRID_VERSION)
+                        && (header.rows > 0) && (header.columns > 0)
+                        && (header.rows <= uint64_t(INT32_MAX)) && (header.columns <= uint64_t(INT32_MAX));
+        if(!valid) return false;
+        if(pipe(wake) != 0) return false;
+
+        fd = descriptor;
+        ownsFd = false;
+        numRows = int(header.rows);
+        numColumns = int(header.columns);
+        wordsPerRow = packedWordsPerRow(numColumns);
+        const size_t rowBytes = size_t(wordsPerRow) * sizeof(uint64_t);
+        rowsPerChunk = int(std::min<size_t>(std::max<size_t>(1, chunkBytes / rowBytes), size_t(numRows)));
+        for(Chunk& chunk : chunks) {
+            chunk.words.assign(size_t(rowsPerChunk) * wordsPerRow, 0);
+            chunk.rows = 0;
+            chunk.full = false;
+        }
+        rowsQueued = 0;
+        consumed = -1;
+        stopping = false;
+        failed = false;
+        reader = std::thread([this] { readChunks(); });
+        return true;
+    }
+
+    // Synopsis
+    //     stop the reads, a read waiting for data is woken up, and close the file opened by path
+    void close() {
+        if(reader.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(chunkLock);
+                stopping = true;
+            }
+            chunkCond.notify_all();
+            const char byte = 0;
+            while((::write(wake[1], &byte, 1) < 0) && (errno == EINTR)) {}
+            reader.join();
+        }
+        for(int& end : wake) {
+            if(end >= 0) ::close(end);
+            end = -1;
+        }
+        if(ownsFd && (fd >= 0)) ::close(fd);
+        fd = -1;
+        ownsFd = false;
+    }
+
+    int rows() const { return numRows; }
+    int columns() const { return numColumns; }
+
+    // Output
+    //     the next chunk of rows, valid until the next call; no row at the end of the grid or if a read failed
+    // Synopsis
+    //     the chunk returned by the previous call is handed back to the reader, which fills it while this one
+    //     is scanned
+    PackedGridView next() {
+        std::unique_lock<std::mutex> lock(chunkLock);
+        if(consumed >= 0) {
+            if(chunks[consumed].rows == 0) return PackedGridView{ nullptr, 0, numColumns, wordsPerRow };
+            chunks[consumed].full = false;
+            chunkCond.notify_all();
+        }
+        consumed = (consumed + 1) % 2;
+        chunkCond.wait(lock, [&] { return chunks[consumed].full; });
+        return PackedGridView{ chunks[consumed].words.data(), chunks[consumed].rows, numColumns, wordsPerRow };
+    }
+
+    // Output
+    //     true if the stream ended before its last row or a read failed
+    bool truncated() const {
+        std::lock_guard<std::mutex> lock(chunkLock);
+        return failed;
+    }
+
+private:
+    struct Chunk {
+        std::vector<uint64_t> words;
+        int rows;  // the rows read into words, 0 for the end of the grid
+        bool full; // filled by the reader and not yet handed back by next()
+    };
+
+    // Input
+    //     wakeFd : if not -1, the read gives up as soon as wakeFd is readable, see close()
+    static bool readFully(int descriptor, void* buffer, size_t bytes, int wakeFd = -1) {
+        char* p = static_cast<char*>(buffer);
+        while(bytes > 0) {
+            if(wakeFd >= 0) {
+                pollfd fds[2] = { { descriptor, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+                if(poll(fds, 2, -1) < 0) {
+                    if(errno == EINTR) continue;
+                    return false;
+                }
+                if(fds[1].revents != 0) return false;
+            }
+            const ssize_t n = ::read(descriptor, p, bytes);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            p += n;
+            bytes -= size_t(n);
+        }
+        return true;
+    }
+
+    // the reader thread: the chunks are filled in turn, each one once next() has handed it back
+    void readChunks() {
+        for(int filling = 0; ; filling = (filling + 1) % 2) {
+            {
+                std::unique_lock<std::mutex> lock(chunkLock);
+                chunkCond.wait(lock, [&] { return stopping || !chunks[filling].full; });
+                if(stopping) return;
+            }
+            const int rowsToRead = std::min(rowsPerChunk, numRows - rowsQueued);
+            const bool ok = readFully(fd, chunks[filling].words.data(), size_t(rowsToRead) * wordsPerRow * sizeof(uint64_t),
+                                      wake[0]);
+            rowsQueued += rowsToRead;
+            {
+                std::lock_guard<std::mutex> lock(chunkLock);
+                chunks[filling].rows = ok ? rowsToRead : 0;
+                chunks[filling].full = true;
+                failed = !ok;
+            }
+            chunkCond.notify_all();
+            if(!ok || (rowsToRead == 0)) return;
+        }
+    }
+
+    int fd;
+    bool ownsFd;
+    int wake[2]; // the wakeup pipe of the reader, written by close()
+    int numRows;
+    int numColumns;
+    int wordsPerRow;
+    int rowsPerChunk;
+    int rowsQueued; // the rows the reader has read, only touched by the reader thread
+    int consumed;   // the chunk returned by the last next(), -1 before the first one
+
+    Chunk chunks[2];
+    mutable std::mutex chunkLock;
+    std::condition_variable chunkCond;
+    bool stopping;
+    bool failed;
+    std::thread reader;
+};
+
+#endif
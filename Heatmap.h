@@ -0,0 +1,164 @@
+// The heatmap of the paths through every cell, in a memory-mapped file, so that a heatmap larger than RAM is
+// written a tile at a time: the pages of a finished tile are handed back to the page cache, which writes them out.
+//
+// File format, little endian:
+//     offset  0 : magic "RGHT"
+//     offset  4 : uint32 version, HEATMAP_VERSION
+//     offset  8 : uint64 rows
+//     offset 16 : uint64 columns
+//     offset 24 : uint32 bytes of a counter
+//     offset 28 : uint32 zero, then zeros up to HEATMAP_DATA_OFFSET
+//     offset HEATMAP_DATA_OFFSET : rows * columns counters, row major, as the Counter of the engine holds them
+//                 (e.g. a ModCounter in Montgomery form), read back through MappedHeatmap<Counter>.
+//                 The counters start on a page, so the rows of a tile whose bytes are a multiple of the page
+//                 are whole pages and are all released
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include<cstdint>     // for uint32_t, uint64_t
+#include<cstring>     // for memcmp, memcpy
+#include<type_traits> // for std::is_trivially_copyable
+#include<fcntl.h>     // for open
+#include<sys/mman.h>  // for mmap, munmap, madvise
+#include<sys/stat.h>  // for fstat
+#include<unistd.h>    // for close, ftruncate, sysconf
+
+constexpr uint32_t HEATMAP_VERSION = 1;
+constexpr char HEATMAP_MAGIC[4] = { 'R', 'G', 'H', 'T' };
+
+struct HeatmapHeader {
+    char     magic[4];
+    uint32_t version;
+    uint64_t rows;
+    uint64_t columns;
+    uint32_t counterBytes;
+    uint32_t zero;
+};
+static_assert(sizeof(HeatmapHeader) == 32, "the header is part of the file format");
+
+// a page on every common configuration, the mapping itself starting on a page
+constexpr size_t HEATMAP_DATA_OFFSET = 4096;
+
+template<typename Counter>
+class MappedHeatmap {
+    static_assert(std::is_trivially_copyable<Counter>::value, "the counters are the bytes of the file");
+
+public:
+    MappedHeatmap() : data(nullptr), length(0), numRows(0), numColumns(0) {}
+    ~MappedHeatmap() { close(); }
+    MappedHeatmap(const MappedHeatmap&) = delete;
+    MappedHeatmap& operator=(const MappedHeatmap&) = delete;
+
+    // Input
+    //     path    : the heatmap file to be written, truncated if it exists
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    // Output
+    //     true if the file has its full size and is mapped for writing
+    bool create(const char* path, int rows, int columns) {
+        close();
+        int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return false;
+        const size_t size = HEATMAP_DATA_OFFSET + size_t(rows) * columns * sizeof(Counter);
+        if(ftruncate(fd, off_t(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED) return false;
+        data = static_cast<char*>(mapped);
+        length = size;
+        numRows = rows;
+        numColumns = columns;
+
+        HeatmapHeader header;
+        memcpy(header.magic, HEATMAP_MAGIC, sizeof(header.magic));
+        header.version = HEATMAP_VERSION;
+        header.rows = uint64_t(rows);
+        header.columns = uint64_t(columns);
+        header.counterBytes = uint32_t(sizeof(Counter));
+        header.zero = 0;
+        memcpy(data, &header, sizeof(header));
+        return true;
+    }
+
+    // Input
+    //     path : the heatmap file
+    // Output
+    //     true if the file is mapped and its header is valid for Counter
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if(fd < 0) return false;
+        struct stat st;
+        if((fstat(fd, &st) != 0) || (size_t(st.st_size) < HEATMAP_DATA_OFFSET)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED) return false;
+        data = static_cast<char*>(mapped);
+        length = size_t(st.st_size);
+
+        HeatmapHeader header;
+        memcpy(&header, data, sizeof(header));
+        const bool valid = (memcmp(header.magic, HEATMAP_MAGIC, sizeof(header.magic)) == 0)
+                        && (header.version == HEATMAP_VERSION) && (header.counterBytes == sizeof(Counter))
+                        && (header.rows <= uint64_t(INT32_MAX)) && (header.columns <= uint64_t(INT32_MAX))
+                        && ((length - HEATMAP_DATA_OFFSET) / sizeof(Counter) >= header.rows * header.columns);
+        if(!valid) {
+            close();
+            return false;
+        }
+        numRows = int(header.rows);
+        numColumns = int(header.columns);
+        return true;
+    }
+
+    void close() {
+        if(data != nullptr) {
+            munmap(data, length);
+            data = nullptr;
+            length = 0;
+        }
+    }
+
+    int rows() const { return numRows; }
+    int columns() const { return numColumns; }
+
+    Counter* row(int i) { return reinterpret_cast<Counter*>(data + HEATMAP_DATA_OFFSET) + size_t(i) * numColumns; }
+    const Counter* row(int i) const {
+        return reinterpret_cast<const Counter*>(data + HEATMAP_DATA_OFFSET) + size_t(i) * numColumns;
+    }
+
+    // Input
+    //     rowBegin, rowEnd       : the rows of the tile
+    //     columnBegin, columnEnd : the columns of the tile
+    // Synopsis
+    //     drop the pages of the tile from the process, the page cache keeps and writes back what was written.
+    //     Only the pages wholly inside a row of the tile are dropped, a page shared with a neighbour tile,
+    //     which another worker may be writing, stays
+    void release(int rowBegin, int rowEnd, int columnBegin, int columnEnd) {
+        static const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+        for(int i = rowBegin; i < rowEnd; i++) {
+            const uintptr_t begin = reinterpret_cast<uintptr_t>(row(i) + columnBegin);
+            const uintptr_t end = reinterpret_cast<uintptr_t>(row(i) + columnEnd);
+            const uintptr_t first = (begin + pageSize - 1) & ~(pageSize - 1);
+            const uintptr_t last = end & ~(pageSize - 1);
+            if(first < last) {
+                madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+            }
+        }
+    }
+
+private:
+    char* data;
+    size_t length;
+    int numRows;
+    int numColumns;
+};
+
+#endif
@@ -0,0 +1,173 @@
+// Bit-packed grid, one bit per cell: 1 for FLATLAND and 0 for SNAKE.
+// Every row is padded to a whole number of 64-bit words, the padding bits are 0.
+//
+// On-disk format, little endian:
+//     offset  0 : magic "RGHG"
+//     offset  4 : uint32 version, PACKED_GRID_VERSION
+//     offset  8 : uint64 rows
+//     offset 16 : uint64 columns
+//     offset 24 : rows * ((columns + 63) / 64) uint64 words, row major, bit j % 64 of word j / 64 is column j
+// The file is opened with mmap and the counting engines of Answer-A read the payload in place through
+// PackedGridView; the path searches of Answer-D and Answer-E expand it into their PaddedGrid first.
+
+#ifndef PACKED_GRID_H
+#define PACKED_GRID_H
+
+#include<cstdint>    // for uint32_t, uint64_t
+#include<cstdio>     // for FILE, fopen, fwrite
+#include<cstring>    // for memcmp, memcpy
+#include<vector>     // for std::vector
+#include<fcntl.h>    // for open
+#include<sys/mman.h> // for mmap, munmap
+#include<sys/stat.h> // for fstat
+#include<unistd.h>   // for close
+
+constexpr uint32_t PACKED_GRID_VERSION = 1;
+constexpr char PACKED_GRID_MAGIC[4] = { 'R', 'G', 'H', 'G' };
+
+struct PackedGridHeader {
+    char     magic[4];
+    uint32_t version;
+    uint64_t rows;
+    uint64_t columns;
+};
+static_assert(sizeof(PackedGridHeader) == 24, "the header is part of the file format");
+
+// One row of bits, flags[j] is 1 for FLATLAND and 0 for SNAKE like a CELLFLAG row
+struct PackedBits {
+    const uint64_t* words;
+
+    int operator[](int j) const { return int((words[j >> 6] >> (j & 63)) & 1); }
+};
+
+// Read only view of a packed grid, it does not own the words
+struct PackedGridView {
+    const uint64_t* words;
+    int rows;
+    int columns;
+    int wordsPerRow;
+
+    PackedBits row(int i) const { return PackedBits{ words + size_t(i) * wordsPerRow }; }
+
+    // Input
+    //     pos : the cell index by row major order, the same index as in a CELLFLAG grid
+    // Output
+    //     1 for FLATLAND and 0 for SNAKE
+    int operator[](int pos) const {
+        const int i = pos / columns;
+        return row(i)[pos - i * columns];
+    }
+};
+
+inline int packedWordsPerRow(int columns) {
+    return int((int64_t(columns) + 63) / 64);
+}
+
+// In memory packed grid which owns its words
+class PackedGrid {
+public:
+    // Input
+    //     grid    : the pointer which points to the matrix by row major order, FLATLAND is 1
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    template<typename Flag>
+    PackedGrid(const Flag* grid, int rows, int columns)
+        : rows(rows), columns(columns), words(size_t(rows) * packedWordsPerRow(columns), 0) {
+        const int wordsPerRow = packedWordsPerRow(columns);
+        for(int i = 0; i < rows; i++) {
+            for(int j = 0; j < columns; j++) {
+                words[size_t(i) * wordsPerRow + (j >> 6)] |= uint64_t(grid[size_t(i) * columns + j] != 0) << (j & 63);
+            }
+        }
+    }
+
+    PackedGridView view() const {
+        return PackedGridView{ words.data(), rows, columns, packedWordsPerRow(columns) };
+    }
+
+    // Input
+    //     path : the file to be written
+    // Output
+    //     true if the whole file is written
+    bool write(const char* path) const {
+        PackedGridHeader header;
+        memcpy(header.magic, PACKED_GRID_MAGIC, sizeof(header.magic));
+        header.version = PACKED_GRID_VERSION;
+        header.rows = uint64_t(rows);
+        header.columns = uint64_t(columns);
+
+        FILE* file = fopen(path, "wb");
+        if(file == nullptr) return false;
+        bool ok = (fwrite(&header, sizeof(header), 1, file) == 1)
+               && (fwrite(words.data(), sizeof(uint64_t), words.size(), file) == words.size());
+        return (fclose(file) == 0) && ok;
+    }
+
+private:
+    int rows;
+    int columns;
+    std::vector<uint64_t> words;
+};
+
+// Packed grid file mapped read only into memory
+class MappedGrid {
+public:
+    MappedGrid() : data(nullptr), length(0) {}
+    ~MappedGrid() { close(); }
+    MappedGrid(const MappedGrid&) = delete;
+    MappedGrid& operator=(const MappedGrid&) = delete;
+
+    // Input
+    //     path : the packed grid file
+    // Output
+    //     true if the file is mapped and its header is valid
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if(fd < 0) return false;
+        struct stat st;
+        if((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(PackedGridHeader))) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED) return false;
+        data = static_cast<const char*>(mapped);
+        length = size_t(st.st_size);
+
+        const PackedGridHeader* header = reinterpret_cast<const PackedGridHeader*>(data);
+        const bool valid = (memcmp(header->magic, PACKED_GRID_MAGIC, sizeof(header->magic)) == 0)
+                        && (header->version == PACKED_GRID_VERSION)
+                        && (header->rows > 0) && (header->columns > 0)
+                        && (header->rows <= uint64_t(INT32_MAX)) && (header->columns <= uint64_t(INT32_MAX))
+                        && (length - sizeof(PackedGridHeader)) / sizeof(uint64_t) / header->rows
+                           >= uint64_t(packedWordsPerRow(int(header->columns)));
+        if(!valid) {
+            close();
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if(data != nullptr) {
+            munmap(const_cast<char*>(data), length);
+            data = nullptr;
+            length = 0;
+        }
+    }
+
+    PackedGridView view() const {
+        const PackedGridHeader* header = reinterpret_cast<const PackedGridHeader*>(data);
+        return PackedGridView{ reinterpret_cast<const uint64_t*>(data + sizeof(PackedGridHeader)),
+                               int(header->rows), int(header->columns), packedWordsPerRow(int(header->columns)) };
+    }
+
+private:
+    const char* data;
+    size_t length;
+};
+
+#endif
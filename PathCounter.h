@@ -0,0 +1,316 @@
+// Counter policies for the path counting dynamic programming.
+// The number of paths grows like a binomial coefficient, so a plain int overflows around a 17*17 grid without snakes.
+// Every policy below provides the two operations the DP needs:
+//     a += b           : add the paths coming from the neighbour
+//     maskPaths(a, f)  : keep a on FLATLAND (f == 1) and clear it on SNAKE (f == 0), without a data-dependent branch
+// and toString(a) to report the result.
+// The exact policies also provide chooseFirst(rng, a, b), the choice between two counts used by the path samplers.
+
+#ifndef PATH_COUNTER_H
+#define PATH_COUNTER_H
+
+#include<cstdint>     // for uint32_t, uint64_t
+#include<string>      // for std::string
+#include<type_traits> // for std::is_integral
+#include<vector>      // for std::vector
+#include<algorithm>   // for std::max, std::reverse
+
+typedef unsigned __int128 uint128_t;
+
+// Input
+//     paths : the counter of a cell
+//     flag  : the flag of the cell, 0 for SNAKE and 1 for FLATLAND
+// Output
+//     paths is unchanged on FLATLAND and zero on SNAKE
+// Synopsis
+//     0 - flag is a mask of all zero bits or all one bits, also in a constant expression
+template<typename Counter>
+constexpr void maskPaths(Counter& paths, int flag) {
+    static_assert(std::is_integral<Counter>::value || std::is_same<Counter, uint128_t>::value, "no maskPaths for this counter");
+    paths &= (Counter(0) - Counter(flag));
+}
+
+template<typename Counter>
+inline std::string toString(Counter paths) {
+    static_assert(std::is_integral<Counter>::value || std::is_same<Counter, uint128_t>::value, "no toString for this counter");
+    if(paths == 0) return "0";
+    bool negative = false;
+    if constexpr(std::is_signed<Counter>::value) negative = paths < 0;
+    std::string digits;
+    while(paths != 0) {
+        int digit = int(paths % 10);
+        digits.push_back(char('0' + (negative ? -digit : digit)));
+        paths /= 10;
+    }
+    if(negative) digits.push_back('-');
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+// Input
+//     rng   : a generator of uniform 64-bit words, e.g. std::mt19937_64
+//     first : the weight of the first choice
+//     total : the sum of the weights, 0 <= first <= total and total > 0
+// Output
+//     true with probability first / total, exactly
+// Synopsis
+//     a uniform r in [0, total) by rejection on the bit length of total, compared with first
+template<typename Counter, typename Rng>
+inline bool chooseFirst(Rng& rng, const Counter& first, const Counter& total) {
+    static_assert(std::is_integral<Counter>::value || std::is_same<Counter, uint128_t>::value, "no chooseFirst for this counter");
+    typedef typename std::conditional<(sizeof(Counter) > sizeof(uint64_t)), uint128_t, uint64_t>::type Word;
+    const Word bound = Word(total);
+    Word mask = bound - 1;
+    for(int shift = 1; shift < int(8 * sizeof(Word)); shift <<= 1) {
+        mask |= mask >> shift;
+    }
+    for(;;) {
+        Word r = Word(uint64_t(rng()));
+        if constexpr(sizeof(Word) > sizeof(uint64_t)) r = (r << 64) | Word(uint64_t(rng()));
+        r &= mask;
+        if(r < bound) return r < Word(first);
+    }
+}
+
+// Counter modulo the odd prime Mod, kept in Montgomery form (value * 2^32 mod Mod).
+// Addition is the plain modular addition; the Montgomery form makes the multiplication used by the
+// combinatorial solvers a REDC instead of a 64-bit division.
+template<uint32_t Mod>
+class MontgomeryCounter {
+    static_assert((Mod & 1) != 0 && Mod < (1u << 31), "Mod must be odd and below 2^31");
+
+public:
+    MontgomeryCounter() : mont(0) {}
+    MontgomeryCounter(uint64_t value) : mont(reduce((value % Mod) * R2)) {}
+
+    // Output
+    //     the counter as an ordinary residue in [0, Mod)
+    uint32_t value() const { return reduce(mont); }
+
+    MontgomeryCounter& operator+=(const MontgomeryCounter& other) {
+        uint32_t sum = mont + other.mont;
+        mont = sum - (Mod & (0u - uint32_t(sum >= Mod)));
+        return *this;
+    }
+
+    MontgomeryCounter& operator-=(const MontgomeryCounter& other) {
+        uint32_t diff = mont - other.mont;
+        mont = diff + (Mod & (0u - uint32_t(mont < other.mont)));
+        return *this;
+    }
+
+    MontgomeryCounter& operator*=(const MontgomeryCounter& other) {
+        mont = reduce(uint64_t(mont) * other.mont);
+        return *this;
+    }
+
+    friend MontgomeryCounter operator+(MontgomeryCounter a, const MontgomeryCounter& b) { return a += b; }
+    friend MontgomeryCounter operator-(MontgomeryCounter a, const MontgomeryCounter& b) { return a -= b; }
+    friend MontgomeryCounter operator*(MontgomeryCounter a, const MontgomeryCounter& b) { return a *= b; }
+    friend bool operator==(const MontgomeryCounter& a, const MontgomeryCounter& b) { return a.mont == b.mont; }
+    friend bool operator!=(const MontgomeryCounter& a, const MontgomeryCounter& b) { return a.mont != b.mont; }
+
+    // Output
+    //     the multiplicative inverse, by Fermat's little theorem since Mod is prime
+    MontgomeryCounter inverse() const {
+        MontgomeryCounter result(1);
+        MontgomeryCounter base = *this;
+        for(uint32_t e = Mod - 2; e != 0; e >>= 1) {
+            if(e & 1) result *= base;
+            base *= base;
+        }
+        return result;
+    }
+
+    friend void maskPaths(MontgomeryCounter& paths, int flag) {
+        paths.mont &= (0u - uint32_t(flag));
+    }
+
+    friend std::string toString(const MontgomeryCounter& paths) {
+        return std::to_string(paths.value());
+    }
+
+private:
+    // -Mod^(-1) mod 2^32 by Newton iteration
+    static constexpr uint32_t negInverse() {
+        uint32_t inv = Mod;
+        for(int i = 0; i < 5; i++) inv *= 2u - Mod * inv;
+        return 0u - inv;
+    }
+    static constexpr uint64_t R2 = ((unsigned __int128)1 << 64) % Mod; // 2^64 mod Mod
+    static constexpr uint32_t NEG_INV = negInverse();
+
+    // REDC: t * 2^(-32) mod Mod for t < Mod * 2^32
+    static uint32_t reduce(uint64_t t) {
+        uint32_t m = uint32_t(t) * NEG_INV;
+        uint32_t r = uint32_t((t + uint64_t(m) * Mod) >> 32);
+        return r - (Mod & (0u - uint32_t(r >= Mod)));
+    }
+
+    uint32_t mont;
+};
+
+typedef MontgomeryCounter<998244353> ModCounter;
+
+// true for the counters modulo a prime, which the combinatorial solvers can use
+template<typename Counter>
+struct IsModCounter : std::false_type {
+};
+
+template<uint32_t Mod>
+struct IsModCounter<MontgomeryCounter<Mod>> : std::true_type {
+    static constexpr uint32_t MODULUS = Mod;
+};
+
+// Arbitrary-precision counter.
+// Limbs are radix 2^32 digits held in 64-bit slots, so an addition is an element-wise limb add with no
+// carry chain and vectorizes; the upper 32 bits of each slot collect the pending carries.
+// Every addition uses at most one more bit of that headroom, and carries are only propagated once
+// it is nearly exhausted.
+class BigCounter {
+public:
+    BigCounter() : pendingBits(0) {}
+    BigCounter(uint64_t value) : pendingBits(0) {
+        while(value != 0) {
+            limbs.push_back(value & LIMB_MASK);
+            value >>= LIMB_BITS;
+        }
+    }
+
+    BigCounter& operator+=(const BigCounter& other) {
+        if(limbs.size() < other.limbs.size()) {
+            limbs.resize(other.limbs.size(), 0);
+        }
+        uint64_t* dst = limbs.data();
+        const uint64_t* src = other.limbs.data();
+        const size_t n = other.limbs.size();
+        for(size_t i = 0; i < n; i++) { // no carry between limbs, vectorizable
+            dst[i] += src[i];
+        }
+        pendingBits = std::max(pendingBits, other.pendingBits) + 1;
+        if(pendingBits >= MAX_PENDING_BITS) {
+            normalize();
+        }
+        return *this;
+    }
+
+    friend BigCounter operator+(BigCounter a, const BigCounter& b) { return a += b; }
+    friend bool operator==(const BigCounter& a, const BigCounter& b) { return toString(a) == toString(b); }
+    friend bool operator!=(const BigCounter& a, const BigCounter& b) { return !(a == b); }
+
+    // Synopsis
+    //     propagate the pending carries so that every limb holds one radix 2^32 digit
+    void normalize() {
+        uint64_t carry = 0;
+        for(size_t i = 0; i < limbs.size(); i++) {
+            uint64_t v = limbs[i] + carry;
+            limbs[i] = v & LIMB_MASK;
+            carry = v >> LIMB_BITS;
+        }
+        while(carry != 0) {
+            limbs.push_back(carry & LIMB_MASK);
+            carry >>= LIMB_BITS;
+        }
+        while(!limbs.empty() && limbs.back() == 0) {
+            limbs.pop_back();
+        }
+        pendingBits = 0;
+    }
+
+    // Output
+    //     the counter modulo m, m below 2^32
+    uint32_t modulo(uint32_t m) const {
+        BigCounter tmp = *this;
+        tmp.normalize();
+        uint64_t r = 0;
+        for(size_t i = tmp.limbs.size(); i-- > 0;) {
+            r = ((r << LIMB_BITS) | tmp.limbs[i]) % m;
+        }
+        return uint32_t(r);
+    }
+
+    friend void maskPaths(BigCounter& paths, int flag) {
+        const uint64_t mask = 0 - uint64_t(flag);
+        for(uint64_t& limb : paths.limbs) { // vectorizable, no branch on the flag
+            limb &= mask;
+        }
+    }
+
+    // Output
+    //     true with probability first / total, exactly, see chooseFirst above
+    // Synopsis
+    //     the uniform r in [0, total) is drawn one limb at a time from the most significant one and only until
+    //     its order against first and total is known, which almost always takes one or two limbs
+    template<typename Rng>
+    friend bool chooseFirst(Rng& rng, const BigCounter& first, const BigCounter& total) {
+        if((first.pendingBits != 0) || (total.pendingBits != 0)) {
+            BigCounter a = first;
+            BigCounter b = total;
+            a.normalize();
+            b.normalize();
+            return chooseFirst(rng, a, b);
+        }
+        const size_t n = total.limbs.size();
+        uint64_t topMask = total.limbs[n - 1];
+        for(int shift = 1; shift < LIMB_BITS; shift <<= 1) {
+            topMask |= topMask >> shift;
+        }
+        for(;;) {
+            int belowTotal = 0; // 0 while the digits of r equal those of total, 1 once r < total
+            int againstFirst = 0; // 0 while the digits of r equal those of first, then -1 for r < first and 1 for r > first
+            bool rejected = false;
+            for(size_t i = n; i-- > 0;) {
+                const uint64_t digit = uint64_t(rng()) & ((i == n - 1) ? topMask : LIMB_MASK);
+                if(belowTotal == 0) {
+                    if(digit > total.limbs[i]) {
+                        rejected = true;
+                        break;
+                    }
+                    belowTotal = (digit < total.limbs[i]);
+                }
+                if(againstFirst == 0) {
+                    const uint64_t f = (i < first.limbs.size()) ? first.limbs[i] : 0;
+                    againstFirst = (digit < f) ? -1 : (digit > f) ? 1 : 0;
+                }
+                if(againstFirst < 0) return true; // r < first <= total
+                if((againstFirst > 0) && (belowTotal != 0)) return false;
+            }
+            if(!rejected && (belowTotal != 0)) return false; // r == first
+        }
+    }
+
+    friend std::string toString(const BigCounter& paths) {
+        BigCounter tmp = paths;
+        tmp.normalize();
+        if(tmp.limbs.empty()) return "0";
+        std::string digits;
+        while(!tmp.limbs.empty()) { // divide by 10^9 until zero
+            uint64_t r = 0;
+            for(size_t i = tmp.limbs.size(); i-- > 0;) {
+                uint64_t cur = (r << LIMB_BITS) | tmp.limbs[i];
+                tmp.limbs[i] = cur / 1000000000u;
+                r = cur % 1000000000u;
+            }
+            while(!tmp.limbs.empty() && tmp.limbs.back() == 0) {
+                tmp.limbs.pop_back();
+            }
+            for(int k = 0; k < 9; k++) {
+                digits.push_back(char('0' + r % 10));
+                r /= 10;
+                if(tmp.limbs.empty() && r == 0) break;
+            }
+        }
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+private:
+    static constexpr int LIMB_BITS = 32;
+    static constexpr uint64_t LIMB_MASK = 0xFFFFFFFFull;
+    static constexpr int MAX_PENDING_BITS = 31;
+
+    std::vector<uint64_t> limbs; // little endian
+    int pendingBits;             // upper bound of the carry bits pending in every limb
+};
+
+#endif
@@ -0,0 +1,286 @@
+// Path sinks of the path enumerations.
+// A sink receives every path found as the array of its cells, cells[i].pos being the cell index by row major order:
+//     sink.path(cells, length)
+// sink.finish() once the enumeration is over, and
+//     sink.sync()
+// before a search offers a checkpoint: the paths received so far are written out to the stream, which is flushed,
+// and the bytes written so far are returned, the offset a resumed run cuts the output back to, see Checkpoint.h.
+//     TextPathSink   : the "0 -> 1 -> 4" text of printAllPaths, through a large buffer instead of one flush per path
+//     BinaryPathSink : a monotone path as one bit per step, 0 for rightwards and 1 for downwards
+//     NullPathSink   : nothing written, only the paths counted
+//     MemoryPathSink : a monotone path as one bit per step in memory, replayed into another sink later
+
+#ifndef PATH_SINK_H
+#define PATH_SINK_H
+
+#include<charconv> // for std::to_chars
+#include<cstdint>  // for uint32_t, uint64_t
+#include<cstring>  // for memcpy, strlen
+#include<istream>  // for std::istream
+#include<iterator> // for std::istreambuf_iterator
+#include<ostream>  // for std::ostream
+#include<vector>   // for std::vector
+
+class TextPathSink {
+public:
+    // Input
+    //     gridName       : the name of grid, printed before the first path
+    //     out            : the stream to be written
+    //     numPathsBefore : the number of paths already printed by the run this one resumes, see Checkpoint.h
+    //     bytesBefore    : the bytes of those paths, the outputBytes of the checkpoint
+    TextPathSink(const char* gridName, std::ostream& out, long long numPathsBefore = 0, long long bytesBefore = 0)
+        : gridName(gridName), out(out), numPaths(numPathsBefore), bytesWritten(bytesBefore), used(0),
+          storage(BUFFER_SIZE), buffer(storage.data()) {}
+    ~TextPathSink() { finish(); }
+    TextPathSink(const TextPathSink&) = delete;
+    TextPathSink& operator=(const TextPathSink&) = delete;
+
+    template<typename Cell>
+    void path(const Cell* cells, int length) {
+        if((++numPaths) == 1) {
+            append("paths of function ");
+            append(gridName);
+            append(": \n");
+        }
+        for(int i = 0; i < length; i++) {
+            if(used + MAX_CELL_TEXT > BUFFER_SIZE) flush();
+            used = size_t(std::to_chars(buffer + used, buffer + BUFFER_SIZE, cells[i].pos).ptr - buffer);
+            if(i + 1 < length) {
+                memcpy(buffer + used, " -> ", 4);
+                used += 4;
+            }
+        }
+        buffer[used++] = '\n';
+    }
+
+    void finish() {
+        flush();
+        out.flush();
+    }
+
+    long long sync() {
+        finish();
+        return bytesWritten;
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    static constexpr size_t MAX_CELL_TEXT = 16; // an int, " -> " and a new line
+
+    void append(const char* text) {
+        for(size_t n = strlen(text); n > 0;) {
+            if(used == BUFFER_SIZE) flush();
+            size_t chunk = (n < BUFFER_SIZE - used) ? n : BUFFER_SIZE - used;
+            memcpy(buffer + used, text, chunk);
+            used += chunk;
+            text += chunk;
+            n -= chunk;
+        }
+    }
+
+    void flush() {
+        out.write(buffer, std::streamsize(used));
+        bytesWritten += (long long)used;
+        used = 0;
+    }
+
+    const char* gridName;
+    std::ostream& out;
+    long long numPaths;
+    long long bytesWritten; // the bytes handed to out, those of the run resumed included
+    size_t used;
+    std::vector<char> storage;
+    char* buffer;
+};
+
+// Binary format, little endian:
+//     offset  0 : magic "RGHP"
+//     offset  4 : uint32 version, BINARY_PATH_VERSION
+//     offset  8 : uint32 rows
+//     offset 12 : uint32 columns
+//     offset 16 : the paths back to back, rows + columns - 2 bits each, bit k of byte n being bit 8 * n + k of the stream,
+//                 padded with 0 bits to a whole byte
+//     the last 8 bytes : uint64 number of paths
+constexpr uint32_t BINARY_PATH_VERSION = 1;
+constexpr uint32_t BINARY_PATH_MAGIC = 0x50484752u; // "RGHP"
+
+class BinaryPathSink {
+public:
+    // Input
+    //     rows    : the number of matrix rows
+    //     columns : the number of matrix columns
+    //     out     : the stream to be written
+    BinaryPathSink(int rows, int columns, std::ostream& out)
+        : out(out), word(0), bits(0), used(0), numPaths(0), bytesWritten(0), finished(false), buffer(BUFFER_WORDS) {
+        const uint32_t header[4] = { BINARY_PATH_MAGIC, BINARY_PATH_VERSION, uint32_t(rows), uint32_t(columns) };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        bytesWritten = sizeof(header);
+    }
+    ~BinaryPathSink() { finish(); }
+
+    template<typename Cell>
+    void path(const Cell* cells, int length) {
+        numPaths++;
+        for(int i = 1; i < length; i++) {
+            word |= uint64_t(cells[i].pos - cells[i - 1].pos != 1) << bits;
+            if((++bits) == 64) {
+                buffer[used++] = word;
+                word = 0;
+                bits = 0;
+                if(used == BUFFER_WORDS) flush();
+            }
+        }
+    }
+
+    // Synopsis
+    //     write the buffered words, the last partial word padded with 0 bits and the number of paths
+    void finish() {
+        if(finished) return;
+        finished = true;
+        if(bits != 0) {
+            buffer[used++] = word;
+            flushBytes((bits + 7) / 8);
+            word = 0;
+            bits = 0;
+        }
+        else {
+            flush();
+        }
+        out.write(reinterpret_cast<const char*>(&numPaths), sizeof(numPaths));
+        bytesWritten += sizeof(numPaths);
+        out.flush();
+    }
+
+    // Synopsis
+    //     write the whole words buffered, the bits of the last partial word stay; the stream is not resumed in
+    //     place, its header and trailing count belong to one run, so the bytes only tell how much of it is out
+    long long sync() {
+        flush();
+        out.flush();
+        return bytesWritten;
+    }
+
+private:
+    static constexpr size_t BUFFER_WORDS = 1 << 16;
+
+    void flush() {
+        flushBytes(8);
+    }
+
+    // the last word of the buffer is written with lastBytes bytes
+    void flushBytes(int lastBytes) {
+        if(used == 0) return;
+        const size_t bytes = (used - 1) * sizeof(uint64_t) + lastBytes;
+        out.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(bytes));
+        bytesWritten += (long long)bytes;
+        used = 0;
+    }
+
+    std::ostream& out;
+    uint64_t word;   // the bits not written yet
+    int bits;        // the number of bits in word
+    size_t used;     // the number of words in buffer
+    uint64_t numPaths;
+    long long bytesWritten;
+    bool finished;
+    std::vector<uint64_t> buffer;
+};
+
+// Input
+//     in : the stream written by a BinaryPathSink
+// Output
+//     the cell indices of every path, empty if the stream is not a binary path stream
+inline std::vector<std::vector<int>> readBinaryPaths(std::istream& in) {
+    std::vector<std::vector<int>> paths;
+    uint32_t header[4];
+    if(!in.read(reinterpret_cast<char*>(header), sizeof(header)) || (header[0] != BINARY_PATH_MAGIC) || (header[1] != BINARY_PATH_VERSION)) {
+        return paths;
+    }
+    const int columns = int(header[3]);
+    const size_t steps = size_t(header[2]) + columns - 2;
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    uint64_t numPaths;
+    if(bytes.size() < sizeof(numPaths)) return paths;
+    memcpy(&numPaths, bytes.data() + bytes.size() - sizeof(numPaths), sizeof(numPaths));
+    bytes.resize(bytes.size() - sizeof(numPaths));
+    if((bytes.size() * 8) < numPaths * steps) return paths;
+    for(size_t bit = 0; paths.size() < numPaths; bit += steps) {
+        std::vector<int> path(1, 0);
+        for(size_t k = 0; k < steps; k++) {
+            const bool down = (bytes[(bit + k) / 8] >> ((bit + k) % 8)) & 1;
+            path.push_back(path.back() + (down ? columns : 1));
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+class NullPathSink {
+public:
+    NullPathSink() : numPaths(0) {}
+
+    template<typename Cell>
+    void path(const Cell*, int) {
+        numPaths++;
+    }
+
+    void finish() {}
+
+    long long sync() { return 0; }
+
+    long long numPaths;
+};
+
+// The cell handed to a sink by MemoryPathSink::replay, a sink only reads pos
+struct PathCell {
+    int pos;
+};
+
+class MemoryPathSink {
+public:
+    // Input
+    //     columns : the number of matrix columns
+    explicit MemoryPathSink(int columns) : columns(columns), steps(0), bits(0), numPaths(0) {}
+
+    // every path goes from the top-left-most cell to the bottom-right-most cell, so all of them have the same length
+    template<typename Cell>
+    void path(const Cell* cells, int length) {
+        numPaths++;
+        steps = length - 1;
+        for(int i = 1; i < length; i++, bits++) {
+            if((bits & 63) == 0) words.push_back(0);
+            words.back() |= uint64_t(cells[i].pos - cells[i - 1].pos != 1) << (bits & 63);
+        }
+    }
+
+    void finish() {}
+
+    long long sync() { return 0; }
+
+    // Synopsis
+    //     hand every path to sink in the order they were received, sink.finish() is not called
+    template<typename Sink>
+    void replay(Sink& sink) const {
+        std::vector<PathCell> cells(size_t(steps) + 1);
+        size_t bit = 0;
+        for(long long n = 0; n < numPaths; n++) {
+            cells[0].pos = 0;
+            for(int k = 1; k <= steps; k++, bit++) {
+                const bool down = (words[bit >> 6] >> (bit & 63)) & 1;
+                cells[k].pos = cells[k - 1].pos + (down ? columns : 1);
+            }
+            sink.path(cells.data(), steps + 1);
+        }
+    }
+
+    long long size() const { return numPaths; }
+
+private:
+    int columns;
+    int steps;     // the number of steps of every path
+    size_t bits;   // the number of bits in words
+    long long numPaths;
+    std::vector<uint64_t> words;
+};
+
+#endif
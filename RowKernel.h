@@ -0,0 +1,282 @@
+// Row kernel of the path counting dynamic programming.
+// One row of dp[i][j] = dp[i-1][j] + dp[i][j-1], cleared on SNAKE, is a segmented prefix sum of the previous row:
+//     x[j] = flag[j] ? up[j] : 0
+//     dp[j] = x[j] + (flag[j] ? dp[j-1] : 0)
+// A pair (x, m) with m the all-ones mask of FLATLAND composes associatively:
+//     (x1, m1) then (x2, m2) = (x2 + (m2 & x1), m1 & m2)
+// so a vector of lanes is scanned in log2(lanes) shift-and-add steps, and the carry of the previous vector
+// is added to every lane whose prefix has no SNAKE.
+// The AVX2 and AVX-512 kernels are compiled with target attributes and picked at runtime, with a scalar fallback,
+// for 32-bit (int) and 64-bit (uint64_t) counters; the other counters always use the scalar kernel.
+// The flags of a row are either CELLFLAG lanes or the bits of a PackedGrid row.
+
+#ifndef ROW_KERNEL_H
+#define ROW_KERNEL_H
+
+#include<cstdint>     // for int32_t, uint64_t
+#include<immintrin.h> // for the AVX2 and AVX-512 intrinsics
+
+#include "PackedGrid.h" // for PackedBits
+
+// Input
+//     num_paths : the row of dp, dp[i-1][*] on input and dp[i][*] on output
+//     flags     : the flags of row i, 0 for SNAKE and 1 for FLATLAND, a CELLFLAG pointer or PackedBits
+//     columns   : the number of cells in the row
+//     carry     : dp[i][-1], the paths entering the row from the left
+// Synopsis
+//     the scalar kernel, also the reference of the vector kernels
+template<typename Counter, typename Flags>
+inline void scanRowScalar(Counter* num_paths, Flags flags, int columns, Counter carry) {
+    num_paths[0] += carry;
+    maskPaths(num_paths[0], flags[0]);
+    for(int j = 1; j < columns; j++) {
+        num_paths[j] += num_paths[j - 1];
+        maskPaths(num_paths[j], flags[j]);
+    }
+}
+
+namespace rowkernel {
+
+// full lane masks, the masked forms of the AVX-512 intrinsics avoid an undefined source operand
+constexpr __mmask16 ALL16 = 0xFFFF;
+constexpr __mmask8 ALL8 = 0xFF;
+
+// The kernels read the flags either as 32-bit CELLFLAG lanes or as the bits of a PackedGrid row.
+// laneMaskN(flags, j) returns all one bits in the lanes of FLATLAND cells j .. j + N - 1, j is a multiple of N.
+inline int flagAt(const int32_t* flags, int j) { return flags[j]; }
+inline int flagAt(PackedBits flags, int j) { return flags[j]; }
+
+inline unsigned packedByte(PackedBits flags, int j) {
+    return reinterpret_cast<const uint8_t*>(flags.words)[j >> 3];
+}
+
+__attribute__((target("avx2")))
+inline __m256i laneMask8x32(const int32_t* flags, int j) {
+    return _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_loadu_si256((const __m256i*)(flags + j)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i laneMask8x32(PackedBits flags, int j) {
+    const __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i byte = _mm256_set1_epi32(int(packedByte(flags, j)));
+    return _mm256_cmpeq_epi32(_mm256_and_si256(byte, bit), bit);
+}
+
+__attribute__((target("avx2")))
+inline __m256i laneMask4x64(const int32_t* flags, int j) {
+    return _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(flags + j))));
+}
+
+__attribute__((target("avx2")))
+inline __m256i laneMask4x64(PackedBits flags, int j) {
+    const __m256i bit = _mm256_setr_epi64x(1, 2, 4, 8);
+    __m256i nibble = _mm256_set1_epi64x((long long)(packedByte(flags, j) >> (j & 4)));
+    return _mm256_cmpeq_epi64(_mm256_and_si256(nibble, bit), bit);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i laneMask16x32(const int32_t* flags, int j) {
+    return _mm512_sub_epi32(_mm512_setzero_si512(), _mm512_loadu_si512(flags + j));
+}
+
+__attribute__((target("avx512f")))
+inline __m512i laneMask16x32(PackedBits flags, int j) {
+    const __mmask16 k = __mmask16(reinterpret_cast<const uint16_t*>(flags.words)[j >> 4]);
+    return _mm512_maskz_mov_epi32(k, _mm512_set1_epi32(-1));
+}
+
+__attribute__((target("avx512f")))
+inline __m512i laneMask8x64(const int32_t* flags, int j) {
+    return _mm512_sub_epi64(_mm512_setzero_si512(), _mm512_maskz_cvtepi32_epi64(ALL8, _mm256_loadu_si256((const __m256i*)(flags + j))));
+}
+
+__attribute__((target("avx512f")))
+inline __m512i laneMask8x64(PackedBits flags, int j) {
+    return _mm512_maskz_mov_epi64(__mmask8(packedByte(flags, j)), _mm512_set1_epi64(-1));
+}
+
+// 32-bit lanes, carry in and out of the function through carry
+template<typename Flags>
+__attribute__((target("avx2")))
+inline void scanRowAvx2(uint32_t* num_paths, Flags flags, int columns, uint32_t& carry) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i vcarry = _mm256_set1_epi32(int(carry));
+    int j = 0;
+    for(; j + 8 <= columns; j += 8) {
+        __m256i m = laneMask8x32(flags, j);
+        __m256i x = _mm256_and_si256(m, _mm256_loadu_si256((const __m256i*)(num_paths + j)));
+        // shift by 1, 2 and 4 lanes towards the higher lanes, zeros for x and ones for m shifted in
+        __m256i t = _mm256_permute2x128_si256(x, x, 0x08);
+        __m256i tm = _mm256_permute2x128_si256(m, ones, 0x02);
+        x = _mm256_add_epi32(x, _mm256_and_si256(m, _mm256_alignr_epi8(x, t, 12)));
+        m = _mm256_and_si256(m, _mm256_alignr_epi8(m, tm, 12));
+        t = _mm256_permute2x128_si256(x, x, 0x08);
+        tm = _mm256_permute2x128_si256(m, ones, 0x02);
+        x = _mm256_add_epi32(x, _mm256_and_si256(m, _mm256_alignr_epi8(x, t, 8)));
+        m = _mm256_and_si256(m, _mm256_alignr_epi8(m, tm, 8));
+        t = _mm256_permute2x128_si256(x, x, 0x08);
+        tm = _mm256_permute2x128_si256(m, ones, 0x02);
+        x = _mm256_add_epi32(x, _mm256_and_si256(m, t));
+        m = _mm256_and_si256(m, tm);
+        x = _mm256_add_epi32(x, _mm256_and_si256(m, vcarry));
+        _mm256_storeu_si256((__m256i*)(num_paths + j), x);
+        vcarry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+    }
+    if(j > 0) carry = num_paths[j - 1];
+    for(; j < columns; j++) {
+        carry = (num_paths[j] + carry) & (0u - uint32_t(flagAt(flags, j)));
+        num_paths[j] = carry;
+    }
+}
+
+template<typename Flags>
+__attribute__((target("avx512f")))
+inline void scanRowAvx512(uint32_t* num_paths, Flags flags, int columns, uint32_t& carry) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi32(-1);
+    __m512i vcarry = _mm512_set1_epi32(int(carry));
+    int j = 0;
+    for(; j + 16 <= columns; j += 16) {
+        __m512i m = laneMask16x32(flags, j);
+        __m512i x = _mm512_and_si512(m, _mm512_loadu_si512(num_paths + j));
+        x = _mm512_add_epi32(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, x, zero, 15)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, m, ones, 15));
+        x = _mm512_add_epi32(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, x, zero, 14)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, m, ones, 14));
+        x = _mm512_add_epi32(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, x, zero, 12)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, m, ones, 12));
+        x = _mm512_add_epi32(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, x, zero, 8)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi32(ALL16, m, ones, 8));
+        x = _mm512_add_epi32(x, _mm512_and_si512(m, vcarry));
+        _mm512_storeu_si512(num_paths + j, x);
+        vcarry = _mm512_maskz_permutexvar_epi32(ALL16, _mm512_set1_epi32(15), x);
+    }
+    if(j > 0) carry = num_paths[j - 1];
+    for(; j < columns; j++) {
+        carry = (num_paths[j] + carry) & (0u - uint32_t(flagAt(flags, j)));
+        num_paths[j] = carry;
+    }
+}
+
+// 64-bit lanes
+template<typename Flags>
+__attribute__((target("avx2")))
+inline void scanRowAvx2(uint64_t* num_paths, Flags flags, int columns, uint64_t& carry) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    __m256i vcarry = _mm256_set1_epi64x((long long)carry);
+    int j = 0;
+    for(; j + 4 <= columns; j += 4) {
+        __m256i m = laneMask4x64(flags, j);
+        __m256i x = _mm256_and_si256(m, _mm256_loadu_si256((const __m256i*)(num_paths + j)));
+        __m256i t = _mm256_permute2x128_si256(x, x, 0x08);
+        __m256i tm = _mm256_permute2x128_si256(m, ones, 0x02);
+        x = _mm256_add_epi64(x, _mm256_and_si256(m, _mm256_alignr_epi8(x, t, 8)));
+        m = _mm256_and_si256(m, _mm256_alignr_epi8(m, tm, 8));
+        t = _mm256_permute2x128_si256(x, x, 0x08);
+        tm = _mm256_permute2x128_si256(m, ones, 0x02);
+        x = _mm256_add_epi64(x, _mm256_and_si256(m, t));
+        m = _mm256_and_si256(m, tm);
+        x = _mm256_add_epi64(x, _mm256_and_si256(m, vcarry));
+        _mm256_storeu_si256((__m256i*)(num_paths + j), x);
+        vcarry = _mm256_permute4x64_epi64(x, 0xFF);
+    }
+    if(j > 0) carry = num_paths[j - 1];
+    for(; j < columns; j++) {
+        carry = (num_paths[j] + carry) & (0ull - uint64_t(flagAt(flags, j)));
+        num_paths[j] = carry;
+    }
+}
+
+template<typename Flags>
+__attribute__((target("avx512f")))
+inline void scanRowAvx512(uint64_t* num_paths, Flags flags, int columns, uint64_t& carry) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi64(-1);
+    __m512i vcarry = _mm512_set1_epi64((long long)carry);
+    int j = 0;
+    for(; j + 8 <= columns; j += 8) {
+        __m512i m = laneMask8x64(flags, j);
+        __m512i x = _mm512_and_si512(m, _mm512_loadu_si512(num_paths + j));
+        x = _mm512_add_epi64(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, x, zero, 7)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, m, ones, 7));
+        x = _mm512_add_epi64(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, x, zero, 6)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, m, ones, 6));
+        x = _mm512_add_epi64(x, _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, x, zero, 4)));
+        m = _mm512_and_si512(m, _mm512_maskz_alignr_epi64(ALL8, m, ones, 4));
+        x = _mm512_add_epi64(x, _mm512_and_si512(m, vcarry));
+        _mm512_storeu_si512(num_paths + j, x);
+        vcarry = _mm512_maskz_permutexvar_epi64(ALL8, _mm512_set1_epi64(7), x);
+    }
+    if(j > 0) carry = num_paths[j - 1];
+    for(; j < columns; j++) {
+        carry = (num_paths[j] + carry) & (0ull - uint64_t(flagAt(flags, j)));
+        num_paths[j] = carry;
+    }
+}
+
+enum Isa {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+// Output
+//     the widest instruction set supported by the running cpu, detected once
+inline Isa detectedIsa() {
+    static const Isa isa = __builtin_cpu_supports("avx512f") ? AVX512 : (__builtin_cpu_supports("avx2") ? AVX2 : SCALAR);
+    return isa;
+}
+
+// Synopsis
+//     the instruction set used by scanRow, the benchmarks lower it to compare the kernels
+inline Isa& selectedIsa() {
+    static Isa isa = detectedIsa();
+    return isa;
+}
+
+// Synopsis
+//     the flags as the kernels read them: 32-bit lanes for a CELLFLAG row, the bits for a PackedGrid row
+template<typename Flag>
+inline const int32_t* kernelFlags(const Flag* flags) {
+    static_assert(sizeof(Flag) == sizeof(int32_t), "the vector kernels load the flags as 32-bit lanes");
+    return reinterpret_cast<const int32_t*>(flags);
+}
+
+inline PackedBits kernelFlags(PackedBits flags) {
+    return flags;
+}
+
+template<typename Lane, typename Flags>
+inline void scanRowVector(Lane* num_paths, Flags flags, int columns, Lane carry) {
+    switch(selectedIsa()) {
+        case AVX512: scanRowAvx512(num_paths, kernelFlags(flags), columns, carry); break;
+        case AVX2:   scanRowAvx2(num_paths, kernelFlags(flags), columns, carry); break;
+        default:     scanRowScalar(num_paths, flags, columns, carry); break;
+    }
+}
+
+} // namespace rowkernel
+
+// Input
+//     num_paths : the row of dp, dp[i-1][*] on input and dp[i][*] on output
+//     flags     : the flags of row i, 0 for SNAKE and 1 for FLATLAND, a CELLFLAG pointer or PackedBits
+//     columns   : the number of cells in the row
+//     carry     : dp[i][-1], the paths entering the row from the left
+// Synopsis
+//     scan one row with the widest kernel available for Counter
+template<typename Counter, typename Flags>
+inline void scanRow(Counter* num_paths, Flags flags, int columns, Counter carry) {
+    scanRowScalar(num_paths, flags, columns, carry);
+}
+
+template<typename Flags>
+inline void scanRow(int* num_paths, Flags flags, int columns, int carry) {
+    rowkernel::scanRowVector(reinterpret_cast<uint32_t*>(num_paths), flags, columns, uint32_t(carry));
+}
+
+template<typename Flags>
+inline void scanRow(uint64_t* num_paths, Flags flags, int columns, uint64_t carry) {
+    rowkernel::scanRowVector(num_paths, flags, columns, carry);
+}
+
+#endif
@@ -0,0 +1,142 @@
+// Counters of the depth first path searches, to tell why a grid takes long.
+// A search takes a Stats policy and calls, on its own thread:
+//     stats.push(depth)         : a cell pushed at depth of the stack, the source being depth 0
+//     stats.pop(depth, cause)   : the cell at depth popped, cause() being the BACKTRACK of a cell which pushed nothing
+// and merges its own Stats into the one of the caller once it is over, so there is no atomic in the loop.
+//     NoSearchStats       : nothing counted, every call is empty and compiled out
+//     CountingSearchStats : the counters below, the JSON of them and a progress line every
+//                           SEARCH_STATS_PROGRESS million cells pushed, from the environment variable of that name
+// SearchStats is the default policy of the searches: CountingSearchStats with -DSEARCH_STATS, NoSearchStats otherwise.
+
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include<algorithm> // for std::max
+#include<chrono>    // for std::chrono::steady_clock
+#include<cstdio>    // for fprintf
+#include<cstdlib>   // for getenv, atoll
+#include<ostream>   // for std::ostream
+#include<vector>    // for std::vector
+
+// Why a cell is popped
+enum BACKTRACK {
+    BACKTRACK_DESTINATION, // the cell is the destination, a path is emitted
+    BACKTRACK_BLOCKED,     // the cell has no move, snakes or the border all around
+    BACKTRACK_VISITED,     // the moves of the cell all lead onto the path
+    BACKTRACK_PRUNED,      // the moves of the cell were all dropped by a pruning, e.g. the cut pruning of Answer-E
+    BACKTRACK_EXHAUSTED,   // the cell pushed at least one cell and every move of it is searched
+    NUM_BACKTRACKS
+};
+
+class NoSearchStats {
+public:
+    static constexpr bool ENABLED = false;
+
+    void push(int) {}
+
+    template<typename Cause>
+    void pop(int, Cause&&) {}
+
+    void merge(const NoSearchStats&) {}
+};
+
+class CountingSearchStats {
+public:
+    static constexpr bool ENABLED = true;
+    static constexpr long long NODES_PER_TICK = 1000000;
+    static constexpr int MAX_BRANCHING = 4; // the moves of a cell in Answer-E
+
+    CountingSearchStats()
+        : nodes(0), maxDepth(0), backtracks(), branching(), ticks(0), tickSeconds(0), slowestTickSeconds(0),
+          untilTick(NODES_PER_TICK), ticksPerLine(0), lastTick(std::chrono::steady_clock::now()) {
+        const char* progress = getenv("SEARCH_STATS_PROGRESS");
+        if(progress != nullptr) ticksPerLine = atoll(progress);
+    }
+
+    void push(int depth) {
+        nodes++;
+        maxDepth = std::max(maxDepth, depth);
+        if(size_t(depth) >= children.size()) children.resize(size_t(depth) * 2 + 2, 0);
+        children[depth] = 0;
+        if(depth > 0) children[depth - 1]++;
+        if(--untilTick == 0) tick(depth);
+    }
+
+    // Input
+    //     depth : the depth of the cell popped
+    //     cause : returns the BACKTRACK of the cell, asked only if the cell pushed nothing
+    template<typename Cause>
+    void pop(int depth, Cause&& cause) {
+        const int pushed = children[depth];
+        branching[std::min(pushed, MAX_BRANCHING)]++;
+        backtracks[(pushed == 0) ? cause() : BACKTRACK_EXHAUSTED]++;
+    }
+
+    // Synopsis
+    //     add the counters of other, e.g. those of a worker thread after it joins
+    void merge(const CountingSearchStats& other) {
+        nodes += other.nodes;
+        maxDepth = std::max(maxDepth, other.maxDepth);
+        for(int k = 0; k < NUM_BACKTRACKS; k++) {
+            backtracks[k] += other.backtracks[k];
+        }
+        for(int k = 0; k <= MAX_BRANCHING; k++) {
+            branching[k] += other.branching[k];
+        }
+        ticks += other.ticks;
+        tickSeconds += other.tickSeconds;
+        slowestTickSeconds = std::max(slowestTickSeconds, other.slowestTickSeconds);
+    }
+
+    // Synopsis
+    //     the counters as one JSON object
+    void writeJson(std::ostream& out) const {
+        static const char* const causes[NUM_BACKTRACKS] = { "destination", "blocked", "visited", "pruned", "exhausted" };
+        out << "{ \"nodes\": " << nodes << ", \"max_depth\": " << maxDepth << ", \"backtracks\": { ";
+        for(int k = 0; k < NUM_BACKTRACKS; k++) {
+            out << (k == 0 ? "" : ", ") << "\"" << causes[k] << "\": " << backtracks[k];
+        }
+        out << " }, \"branching\": [ ";
+        for(int k = 0; k <= MAX_BRANCHING; k++) {
+            out << (k == 0 ? "" : ", ") << branching[k];
+        }
+        out << " ], \"seconds_per_million_nodes\": " << (ticks == 0 ? 0 : tickSeconds / ticks)
+            << ", \"slowest_million_nodes_seconds\": " << slowestTickSeconds << " }";
+    }
+
+    long long nodes;               // the cells pushed
+    int maxDepth;                  // the deepest cell pushed
+    long long backtracks[NUM_BACKTRACKS];
+    long long branching[MAX_BRANCHING + 1]; // the cells popped by the number of cells they pushed
+    long long ticks;               // the NODES_PER_TICK nodes timed
+    double tickSeconds;            // the seconds of all ticks
+    double slowestTickSeconds;
+
+private:
+    void tick(int depth) {
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - lastTick).count();
+        lastTick = now;
+        untilTick = NODES_PER_TICK;
+        ticks++;
+        tickSeconds += seconds;
+        slowestTickSeconds = std::max(slowestTickSeconds, seconds);
+        if((ticksPerLine > 0) && (ticks % ticksPerLine == 0)) {
+            fprintf(stderr, "search: %lld nodes, depth %d, deepest %d, %lld paths, %.3f s per million nodes\n",
+                    nodes, depth, maxDepth, backtracks[BACKTRACK_DESTINATION], seconds);
+        }
+    }
+
+    std::vector<int> children;     // the cells pushed by the cell at every depth of the stack
+    long long untilTick;
+    long long ticksPerLine;
+    std::chrono::steady_clock::time_point lastTick;
+};
+
+#ifdef SEARCH_STATS
+typedef CountingSearchStats SearchStats;
+#else
+typedef NoSearchStats SearchStats;
+#endif
+
+#endif